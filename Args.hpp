@@ -1,6 +1,7 @@
 #ifndef _ASDCVHF374Y192S84DTYBF87HY39486CVATY_
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <cassert>
@@ -34,10 +35,10 @@ public:
 	                      // NOTE: nonexistent entries will return 0, in accordance with NonGreedy (std::map zero-inits primitive types)
 
 	Args(int argc, char const* const* argv, const Rules& rules = {}) // ...use this also when you need to set rules, but not flags
-		: argc(argc), argv(argv), known_options(rules) { proc_next("", 0); }
+		: argc(argc), argv(argv), known_options(rules) { proc(); }
 
 	Args(int argc, char const* const* argv, unsigned flags, const Rules& rules = {}) // ...when you need to set flags, but not rules
-		: flags(flags), argc(argc), argv(argv), known_options(rules) { proc_next("", 0); }
+		: flags(flags), argc(argc), argv(argv), known_options(rules) { proc(); }
 
 	Args() = default;
 	Args(const Args&) = default;
@@ -45,7 +46,7 @@ public:
 
 	bool parse(int argc_, const char* const* argv_, unsigned flags_ = Defaults, const Rules& rules_ = {})
 		{ clear(); argc = argc_; argv = argv_; flags = flags_, known_options = rules_;
-		  proc_next("", 0); return error == None; }
+		  proc(); return error == None; }
 
 	bool reparse(unsigned flags_ = Defaults, const Rules& rules_ = {}) // Uses the original inputs
 		{ return parse(argc, argv, flags_, rules_); }
@@ -91,86 +92,93 @@ protected:
 	std::map<std::string, std::vector<std::string>> named_args;
 	std::vector<std::string> positional_args;
 
-	void proc_next(const std::string& last_opt, int values_to_take, int next_arg_index = 1, bool options_done = false) {
-		auto get_next_word = [&](){ return std::string(next_arg_index < argc ? argv[next_arg_index++] : ""); };
+	void proc() { // One pass over argv (no recursion, and no copying of the args until they're stored)
+		std::string last_opt;    // The option still taking params (if values_to_take != 0)
+		int values_to_take = 0;
+		bool options_done = false;
 		auto handle_duplicate = [this](const std::string& opt){
 			if (!(*this)[opt]) return; // Not a dup.
 			if (  flags & RepeatIsError ) error |= Error::Duplicate;
 			if (!(flags & RepeatAppends)) named_args[opt].clear(); // Reset its param. list...
 		};
-		auto arg = get_next_word();
-		if (arg == "") return;
-		if (options_done) goto process_as_positional; // Idon' wanna see no more if-nesting level...
-		if (values_to_take > 0) { // last_opt still eating parameters?
-	//std::cerr << "- eating '"<< arg <<"' as param. val. for " << last_opt << "\n";
-			assert(!last_opt.empty());
-			named_args[last_opt].emplace_back(arg); // Add current arg as new param. value to last_opt, and...
-			return proc_next(last_opt, --values_to_take, next_arg_index, options_done); // ...continue with last_opt!
-		}
-		// Option (-x, /x, -aggregate, /aggregate, --thing)?...
-		if ((arg[0] == '-' || arg[0] == '/') && arg.size() > 1) { // Option, or -- or // (note: -/ and /- are options!)
-			std::string new_opt;
-			if (arg[1] == '-' && arg.size() > 2) { // --long opt.
-				new_opt = arg.substr(2); // OK, we don't check now... ;)
-				// Extract any =value right now, because the next loop cycle can't (even see it)!
-				//! This also allows --unknown=value, so no need for a rule for each arg
-				auto eqpos = new_opt.find_first_of(":=");
-#define ARG_HAS_EQ eqpos != std::string::npos
-				if (ARG_HAS_EQ) new_opt = new_opt.substr(0, eqpos); // Chop off the =... from the opt. name
-				handle_duplicate(new_opt);
-				if (ARG_HAS_EQ) {
-					if (arg.size() > 2/*for --*/ + eqpos + 1) { // Any value after the =?
-		//std::cerr << "val: " << arg.substr(2, eqpos) << "\n";
-						named_args[new_opt].emplace_back(arg.substr(2 + eqpos+1)); //! Don't crash on `--opt=`
-						auto pc = known_options[new_opt]; // pc: configured param. count, or 0
-						// We have taken (the) one offered value now, regardless of the arity rules!
-						// But, if there's indeed a rule, we're still good, 'coz: if 0, then
-						// the value would just be ignored be the app... :)  And if !0, then
-						// we just need to keep taking more, as needed:
-		//std::cerr << tmp << " params expected for [" << new_opt << "]\n";
-						return proc_next(new_opt, pc<-1? pc+1 : (pc? pc-1 : 0), //!! The pc<-1 case is bogus/incomplete!
-							next_arg_index, options_done);
-					}
-				} else values_to_take = known_options[new_opt]; // Take the next arg(s) instead, if needed
-#undef ARG_HAS_EQ
-			} else if (arg[1] != arg[0]) { // a real short opt, or short opt. aggregate
-//!!				return proc_next("-" + arg.substr(1), next_arg_index, ...state/mode);
-				for (auto c : arg.substr(1)) {
-					new_opt = std::string(1, c);
+		for (int next_arg_index = 1; next_arg_index < argc; ) {
+			std::string_view arg = argv[next_arg_index++];
+			if (arg.empty()) return;
+			if (options_done) goto process_as_positional; // Idon' wanna see no more if-nesting level...
+			if (values_to_take > 0) { // last_opt still eating parameters?
+		//std::cerr << "- eating '"<< arg <<"' as param. val. for " << last_opt << "\n";
+				assert(!last_opt.empty());
+				named_args[last_opt].emplace_back(arg); // Add current arg as new param. value to last_opt, and...
+				--values_to_take;
+				continue; // ...continue with last_opt!
+			}
+			// Option (-x, /x, -aggregate, /aggregate, --thing)?...
+			if ((arg[0] == '-' || arg[0] == '/') && arg.size() > 1) { // Option, or -- or // (note: -/ and /- are options!)
+				std::string new_opt;
+				if (arg[1] == '-' && arg.size() > 2) { // --long opt.
+					auto name = arg.substr(2); // OK, we don't check now... ;)
+					// Extract any =value right now, because the next arg can't (even see it)!
+					//! This also allows --unknown=value, so no need for a rule for each arg
+					auto eqpos = name.find_first_of(":=");
+#define ARG_HAS_EQ eqpos != std::string_view::npos
+					new_opt = std::string(name.substr(0, eqpos)); // Chop off the =... from the opt. name
 					handle_duplicate(new_opt);
-					named_args[new_opt];
+					if (ARG_HAS_EQ) {
+						if (arg.size() > 2/*for --*/ + eqpos + 1) { // Any value after the =?
+							named_args[new_opt].emplace_back(arg.substr(2 + eqpos+1)); //! Don't crash on `--opt=`
+							auto pc = known_options[new_opt]; // pc: configured param. count, or 0
+							// We have taken (the) one offered value now, regardless of the arity rules!
+							// But, if there's indeed a rule, we're still good, 'coz: if 0, then
+							// the value would just be ignored be the app... :)  And if !0, then
+							// we just need to keep taking more, as needed:
+							last_opt = new_opt;
+							values_to_take = pc<-1? pc+1 : (pc? pc-1 : 0); //!! The pc<-1 case is bogus/incomplete!
+							continue;
+						}
+					} else values_to_take = known_options[new_opt]; // Take the next arg(s) instead, if needed
+#undef ARG_HAS_EQ
+				} else if (arg[1] != arg[0]) { // a real short opt, or short opt. aggregate
+					for (auto c : arg.substr(1)) {
+						new_opt = std::string(1, c);
+						handle_duplicate(new_opt);
+						named_args[new_opt];
+					}
+				} else { // -- (by default) or //whatever (always) are positional
+					assert(arg[1] == arg[0]); // (In case I'd reshuffle the cond. above...)
+					if (arg == "--" && !(flags & DashDashIsPositional)) {
+						options_done = true;
+						last_opt = new_opt;
+						values_to_take = 0;
+						continue;
+					}
+					goto process_as_positional;
 				}
-			} else { // -- (by default) or //whatever (always) are positional
-				assert(arg[1] == arg[0]); // (In case I'd reshuffle the cond. above...)
-				if (arg == "--" && !(flags & DashDashIsPositional)) {
-					options_done = true;
-					return proc_next(new_opt, 0, next_arg_index, options_done);
+
+				// We have a new option, process it...
+				if (values_to_take < -1) {
+					error = Unimplemented;
+		//!!std::cerr << "- Not yet supporting variable number of option args.\n";
+					// But it would involve using last_opt, hence the last/new distinction...
 				}
-				goto process_as_positional;
+				// Add the option with an empty param list to start with:
+		//std::cerr << "ready to take next arg as param, if expects any.\n";
+				named_args[new_opt];
+				last_opt = new_opt;
+				values_to_take = known_options[new_opt];
+				continue;
 			}
 
-			// We have a new option, process it...
-			if (values_to_take < -1) {
-				error = Unimplemented;
-	//!!std::cerr << "- Not yet supporting variable number of option args.\n";
-				// But it would involve using last_opt, hence the last/new distinction...
+		process_as_positional:
+		//std::cerr << "- adding unnamed arg (or eating it as param): "<< arg <<"\n";
+			if (values_to_take < 0) { // Well, there's still this greedy option-param case first, so...:
+				named_args[last_opt].emplace_back(arg);
+			} else {
+				positional_args.emplace_back(arg); // Finally! :)
+				last_opt.clear();
+				values_to_take = 0;
 			}
-			// Add the option with an empty param list to start with:
-	//std::cerr << "ready to take next arg as param, if expects any.\n";
-			named_args[new_opt];
-			return proc_next(new_opt, known_options[new_opt], next_arg_index, options_done);
-		}
-
-	process_as_positional:
-	//std::cerr << "- adding unnamed arg (or eating it as param): "<< arg <<"\n";
-		if (values_to_take < 0) { // Well, there's still this greedy option-param case first, so...:
-			named_args[last_opt].emplace_back(arg);
-			return proc_next(last_opt, values_to_take, next_arg_index, options_done);
-		} else {
-			positional_args.push_back(arg); // Finally! :)
-			return proc_next("", 0, next_arg_index, options_done);
 		}
-	};
+	}
 };
 
 #define _ASDCVHF374Y192S84DTYBF87HY39486CVATY_
@@ -0,0 +1,2 @@
+#!/bin/sh
+c++ -std=c++20 -Wall -Wextra -O2 -DNDEBUG -pthread -o wtime wtime.cpp "$@"
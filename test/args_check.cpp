@@ -0,0 +1,63 @@
+// Checks that Args still parses the same way as the old (recursive) version
+// did; the expected results are from that one. Build & run from here with:
+//	c++ -std=c++20 -o args_check args_check.cpp && ./args_check
+
+#include "../Args.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+static string dump(const Args& args) // "name[values] ... | positionals | error"
+{
+	string s;
+	for (auto& [name, values] : args.named()) {
+		s += (s.empty() ? "" : " ") + name + "[";
+		for (size_t i = 0; i < values.size(); ++i) s += (i ? "," : "") + values[i];
+		s += "]";
+	}
+	s += " |";
+	for (auto& arg : args.positional()) s += " " + arg;
+	return s + " | " + to_string(args.error);
+}
+
+int main()
+{
+	const Args::Rules rules = {{"runs", 1}, {"two", 2}, {"greedy", -1}, {"flag", 0}};
+	struct Case { unsigned flags; vector<const char*> argv; string expected; } cases[] = {
+		// Flags, aggregates:
+		{Args::Defaults, {"x", "-v", "-abc", "file"}, "a[] b[] c[] v[] | file | 0"},
+		{Args::Defaults, {"x", "/v", "//server/share", "-/", "-"}, "/[] v[] | //server/share - | 0"},
+		// Params by the rules, --opt=val, --opt:val:
+		{Args::Defaults, {"x", "--runs", "3", "cmd", "-v"}, "runs[3] v[] | cmd | 0"},
+		{Args::Defaults, {"x", "--runs=3", "--flag=on", "--unknown:val", "cmd"}, "flag[on] runs[3] unknown[val] | cmd | 0"},
+		{Args::Defaults, {"x", "--runs=", "3"}, "runs[3] | | 0"},
+		{Args::Defaults, {"x", "--two", "a", "b", "c"}, "two[a,b] | c | 0"},
+		{Args::Defaults, {"x", "--runs"}, "runs[] | | 0"},
+		// Greedy:
+		{Args::Defaults, {"x", "--greedy", "a", "b", "--flag", "c"}, "flag[] greedy[a,b] | c | 0"},
+		{Args::Defaults, {"x", "--greedy", "a", "b"}, "greedy[a,b] | | 0"},
+		// --:
+		{Args::Defaults, {"x", "--", "-v", "--runs", "3"}, " | -v --runs 3 | 0"},
+		{Args::DashDashIsPositional, {"x", "--", "-v"}, "v[] | -- | 0"},
+		// An empty arg ends the parsing:
+		{Args::Defaults, {"x", "-v", "", "after"}, "v[] | | 0"},
+		// Repeated options:
+		{Args::Defaults, {"x", "--runs", "1", "--runs", "2"}, "runs[2] | | 0"},
+		{Args::RepeatAppends, {"x", "--runs", "1", "--runs", "2"}, "runs[1,2] | | 0"},
+		{Args::RepeatIsError, {"x", "--runs", "1", "--runs", "2"}, "runs[2] | | 2"},
+	};
+
+	int failed = 0;
+	for (auto& c : cases) {
+		auto got = dump(Args((int)c.argv.size(), c.argv.data(), c.flags, rules));
+		if (got == c.expected) continue;
+		cerr << "- FAILED:";
+		for (auto arg : c.argv) cerr << " \"" << arg << "\"";
+		cerr << "\n  expected: " << c.expected << "\n  got:      " << got << "\n";
+		++failed;
+	}
+	cout << (size(cases) - failed) << " of " << size(cases) << " OK\n";
+	return failed ? 1 : 0;
+}
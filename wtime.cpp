@@ -1,4 +1,4 @@
-//#include "Args.hpp" <- Disabled for playing with #3...
+#include "Args.hpp"
 
 #include <chrono>
 #include <iostream>
@@ -6,11 +6,70 @@
 #include <string_view>
 #include <cctype> // tolower
 #include <vector>
-//#include <algorithm> // transform, any_of
+#include <cstdint>
+#include <algorithm> // sort, min/max_element
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+#include <fstream>
+#include <cstdio> // snprintf
+#include <ctime>
+#include <cstdlib> // getenv
+#include <map>
+#include <mutex>
+#include <optional>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <latch>
+#include <deque>
+#include <regex>
 #include <cassert>
+#include <ratio>
 
-#define WIN32_LEAN_AND_MEAN
-#include <Windows.h>
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define HAVE_TSC
+#  ifdef _MSC_VER
+#    include <intrin.h> // __rdtsc, __cpuid
+#  else
+#    include <x86intrin.h> // __rdtsc
+#    include <cpuid.h>
+#  endif
+#endif
+
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  define NOMINMAX
+#  include <Windows.h>
+#  include <psapi.h> // GetProcessMemoryInfo
+#  include <tlhelp32.h> // CreateToolhelp32Snapshot
+#  include <cstring> // strlen, _strnicmp
+#  pragma comment(lib, "psapi")
+#else
+#  include <spawn.h>
+#  if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 35)
+#    define HAVE_SPAWN_TCSETPGRP // posix_spawn_file_actions_addtcsetpgrp_np
+#  endif
+#  include <csignal> // sigaction, raise
+#  include <sys/wait.h>
+#  include <sys/resource.h>
+#  include <cerrno>
+#  include <cstring> // strerror
+#  include <unistd.h> // gethostname, access
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <dirent.h>
+#  ifdef __linux__
+#    include <linux/perf_event.h>
+#    include <sys/syscall.h>
+#    include <sys/prctl.h>
+#    include <sched.h> // sched_setaffinity
+#    include <sys/personality.h>
+#  endif
+   extern char** environ;
+#endif
 
 
 using namespace std; // You know, you're not _actually_ obliged to unconditionally
@@ -20,16 +79,40 @@ using namespace std; // You know, you're not _actually_ obliged to unconditional
 const char* TOOLNAME = "wtime";
 const char* VERSION = "2.3.0";
 
+// Our own exit codes (otherwise it's the child's):
+enum ExitCode {
+	EXIT_USAGE      = -1, // Bad options (or just showing the usage)
+	EXIT_RUN_FAILED = -2, // Couldn't run the command
+	EXIT_REGRESSION = -3, // Significantly slower than the baseline (--check-baseline)
+	EXIT_LIMIT      = -4, // Killed at a limit (--timeout, --max-mem, --max-cpu)
+};
+
 
 //============================================================================
 // Config...
 //============================================================================
+namespace TimeUnit // Units of the results, as types (so converting is just a multiplication)
+{
+	struct s   { using period = std::ratio<1>;  static constexpr const char* name = "s"; };
+	struct ms  { using period = std::milli;     static constexpr const char* name = "ms"; };
+	struct us  { using period = std::micro;     static constexpr const char* name = "us"; };
+	struct min { using period = std::ratio<60>; static constexpr const char* name = "min"; };
+}
+
 struct CFG
 {
+	using Report_Time_Unit = TimeUnit::s; // TimeUnit::s, ms, us or min
 
-	string Report_Time_Unit  = "s"; // "s", "ms", "min", "mins", or the full words in plural
 	bool   Verbose           = false;
 	bool   Results_To_Stdout = false; // or stderr
+	unsigned Runs            = 1;     // Measured runs (samples)
+	unsigned Warmup          = 0;     // Extra runs before the measured ones, discarded
+	string Save_Baseline;             // Name to save the measured samples as
+	string Check_Baseline;            // Name of the saved samples to check against
+	double Threshold         = 5;     // %, slowdown tolerated by the baseline check
+	unsigned Calibration_Runs = 100;  // Launches of an empty process to estimate our own overhead
+	bool   Subtract_Overhead = false; // ...and take that off the results
+	bool   CPU_Clock         = false; // Measure the CPU time of the command, not the elapsed time
 } cfg;
 
 
@@ -37,129 +120,379 @@ struct CFG
 // Lib...
 //============================================================================
 
+//----------------------------------------------------------------------------
+class Clock // Selectable time source for Timer (see --clock), as a chrono clock
+//----------------------------------------------------------------------------
+{
+public:
+	enum Source { STEADY, MONOTONIC_RAW, BOOTTIME, TSC, SOURCES };
+	static constexpr const char* Names[SOURCES] = { "steady", "raw", "boottime", "tsc" };
+
+	using duration = chrono::nanoseconds;
+	using rep = duration::rep;
+	using period = duration::period;
+	using time_point = chrono::time_point<Clock>;
+	static constexpr bool is_steady = true;
+
+	static time_point now()
+	{
+		switch (source_) {
+#ifdef HAVE_TSC
+		case TSC: return time_point(duration(rep(double(int64_t(__rdtsc() - tsc_base_)) * tsc_ns_per_tick_))); // (Signed: it may be behind on another core.)
+#endif
+#ifdef __linux__
+		case MONOTONIC_RAW: return read_posix(CLOCK_MONOTONIC_RAW);
+		case BOOTTIME:      return read_posix(CLOCK_BOOTTIME);
+#endif
+		default: return time_point(chrono::duration_cast<duration>(chrono::steady_clock::now().time_since_epoch()));
+		}
+	}
+
+	static bool available(Source s)
+	{
+		switch (s) {
+		case STEADY: return true;
+#ifdef __linux__
+		case MONOTONIC_RAW: case BOOTTIME: return true;
+#endif
+#ifdef HAVE_TSC
+		case TSC: return true;
+#endif
+		default: return false;
+		}
+	}
+
+	static bool select(Source s)
+	{
+		if (!available(s)) return false;
+		if (s == TSC && !tsc_ns_per_tick_) calibrate_tsc();
+		source_ = s;
+		return true;
+	}
+	static Source selected() { return source_; }
+
+	// Nominal resolution (ns), as reported by the OS (0: unknown)
+	static double resolution(Source s)
+	{
+		switch (s) {
+#ifdef HAVE_TSC
+		case TSC: return tsc_ns_per_tick_;
+#endif
+#ifdef __linux__
+		case MONOTONIC_RAW: return res_posix(CLOCK_MONOTONIC_RAW);
+		case BOOTTIME:      return res_posix(CLOCK_BOOTTIME);
+		case STEADY:        return res_posix(CLOCK_MONOTONIC); // (What libstdc++ uses)
+#elif defined(_WIN32)
+		case STEADY: { LARGE_INTEGER f; return QueryPerformanceFrequency(&f) ? 1e9 / double(f.QuadPart) : 0; }
+#endif
+		default: return 0;
+		}
+	}
+
+	static double tsc_ghz() { return tsc_ns_per_tick_ ? 1 / tsc_ns_per_tick_ : 0; }
+
+	// Invariant TSC: constant rate regardless of P-/C-states (CPUID 8000_0007h, EDX bit 8)
+	static bool tsc_invariant()
+	{
+#ifdef HAVE_TSC
+#  ifdef _MSC_VER
+		int regs[4] = {};
+		__cpuid(regs, 0x80000000);
+		if ((unsigned)regs[0] < 0x80000007) return false;
+		__cpuid(regs, 0x80000007);
+		return regs[3] & (1 << 8);
+#  else
+		unsigned eax, ebx, ecx, edx;
+		return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1 << 8));
+#  endif
+#else
+		return false;
+#endif
+	}
+
+private:
+	static inline Source source_ = STEADY;
+	static inline double tsc_ns_per_tick_ = 0;
+	static inline uint64_t tsc_base_ = 0;
+
+#ifndef _WIN32
+	static time_point read_posix(clockid_t id)
+	{
+		timespec ts;
+		clock_gettime(id, &ts);
+		return time_point(duration(rep(ts.tv_sec) * 1000000000 + ts.tv_nsec));
+	}
+	static double res_posix(clockid_t id)
+	{
+		timespec ts;
+		return clock_getres(id, &ts) == 0 ? double(ts.tv_sec) * 1e9 + double(ts.tv_nsec) : 0;
+	}
+#endif
+
+	static void calibrate_tsc() // Against the steady clock, busy-waiting for 50 ms
+	{
+#ifdef HAVE_TSC
+		auto t0 = chrono::steady_clock::now();
+		auto c0 = __rdtsc();
+		chrono::steady_clock::time_point t1;
+		do t1 = chrono::steady_clock::now(); while (t1 - t0 < 50ms);
+		auto c1 = __rdtsc();
+		tsc_ns_per_tick_ = double(chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count()) / double(c1 - c0);
+		tsc_base_ = c0;
+#endif
+	}
+};
+
+//----------------------------------------------------------------------------
 class Timer
+//----------------------------------------------------------------------------
 {
-	using time_point = std::chrono::time_point<std::chrono::high_resolution_clock>;
+public:
+	using time_point = Clock::time_point;
 	enum Control { Null, Start, Hold, Stop };
 	//If switching to enum class:
 	//using Control::Null, Control::Start, Control::Hold, Control::Stop;
 
-	string unit_;
+private:
 	time_point start_;
 	time_point stop_;
 	Control state_ = Null; // Reusing the control enums (relying on common sense)...
 
-	static auto read_()   { return chrono::high_resolution_clock::now(); }
+	static auto read_()   { return Clock::now(); }
 
 public:
-	Timer(string_view unit = "s") : unit_(unit) {}
-	Timer(Control ctrl = Null, string_view unit = "s") : unit_(unit) {
+	Timer(Control ctrl = Null) {
 		if (ctrl == Start) start();
 	}
 
-	auto start()   { start_ = read_(); state_ = Start; return start_; }
-	auto stop()    { stop_  = read_(); state_ = Stop;  return stop_; }
+	time_point start() { start_ = read_(); state_ = Start; return start_; }
+	time_point stop()  { stop_  = read_(); state_ = Stop;  return stop_; }
 	// Allow elapsed() to continue counting after a stop():
 	//auto restart() { state_ = Start; } // Not quite this simple!... :)
 	auto reset()   { state_ = Null; }
 
-	template <typename NumT = float>
-	NumT elapsed() { return state_ == Null ? 0
-		: elapsed<NumT>(start_, state_ == Stop ? stop_ : read_()); }
+	template <typename Unit = TimeUnit::s, typename NumT = double>
+	NumT elapsed() const { return state_ == Null ? 0
+		: elapsed<Unit, NumT>(start_, state_ == Stop ? stop_ : read_()); }
 
-	template <typename NumT = float>
-	NumT elapsed(time_point start_time, time_point stop_time)
+	template <typename Unit = TimeUnit::s, typename NumT = double>
+	static NumT elapsed(time_point start_time, time_point stop_time)
 	{
-		NumT duration_s = std::chrono::duration<NumT>(stop_time - start_time).count();
+		return std::chrono::duration<NumT, typename Unit::period>(stop_time - start_time).count();
+	}
 
-		NumT result;
-		if      (unit_ == "s" || unit_ == "seconds")
-				result = duration_s;
-		else if (unit_ == "ms" || unit_ == "milliseconds")
-				result = duration_s * 1000;
-		else if (unit_ == "min" || unit_ == "mins" || unit_ == "minutes")
-				result = duration_s / 60;
-		else {
-			cerr << "- Warning: unsupported time unit: \""<< unit_ <<"\"! Using seconds instead...\n";
-			result = duration_s;
-		}
-		return result;
+	// Also for values measured elsewhere (e.g. CPU times reported by the OS):
+	template <typename Unit, typename NumT = double>
+	static NumT convert(NumT duration_s)
+	{
+		return duration_s * NumT(Unit::period::den) / NumT(Unit::period::num);
 	}
 };
 
-
 //----------------------------------------------------------------------------
-namespace sys
+struct Stats // Summary of a sample set (e.g. elapsed times of repeated runs)
 //----------------------------------------------------------------------------
 {
-	//----------------------------------------------------------------------------
-	// Detect if this is 32 or 64 bit build
-	//----------------------------------------------------------------------------
-	template <unsigned> unsigned    BitArch();
-	template <>         unsigned    BitArch<4u>() { return 32; }
-	template <>         unsigned    BitArch<8u>() { return 64; }
-	inline const char* BitArchTag()  { return BitArch<sizeof(size_t)>() == 32 ? "32" : "64"; }
+	size_t n = 0;
+	double mean = 0, stddev = 0; // (sample stddev, i.e. n-1)
+	double min = 0, max = 0, median = 0, p90 = 0, p99 = 0;
+	double q1 = 0, q3 = 0;       // Quartiles, for the outlier fences
+	vector<size_t> outliers;     // Indexes of the suspicious samples (Tukey's 1.5 IQR rule)
 
-	//----------------------------------------------------------------------------
-	class ConsoleCP // RAII wrapper around setting/restoring the console code-page
-	//----------------------------------------------------------------------------
+	Stats() = default;
+	Stats(const vector<double>& samples) : n(samples.size())
 	{
-		UINT originalCP;
-		UINT originalOutputCP;
+		if (!n) return;
 
-	public:
-		ConsoleCP(UINT newCP) {
-			originalCP = GetConsoleCP(); // input CP
-			originalOutputCP = GetConsoleOutputCP();
-			SetConsoleCP(newCP);
-			SetConsoleOutputCP(newCP);
-		}
+		vector<double> sorted(samples);
+		sort(sorted.begin(), sorted.end());
+		min = sorted.front();
+		max = sorted.back();
+		median = percentile(sorted, 50);
+		p90 = percentile(sorted, 90);
+		p99 = percentile(sorted, 99);
+		q1 = percentile(sorted, 25);
+		q3 = percentile(sorted, 75);
 
-		~ConsoleCP() {
-			SetConsoleCP(originalCP);
-			SetConsoleOutputCP(originalOutputCP);
+		double sum = 0;
+		for (auto x : samples) sum += x;
+		mean = sum / n;
+		double sqdiffs = 0;
+		for (auto x : samples) sqdiffs += (x - mean) * (x - mean);
+		stddev = n > 1 ? sqrt(sqdiffs / (n - 1)) : 0;
+
+		auto iqr = q3 - q1;
+		for (size_t i = 0; i < n; ++i)
+			if (samples[i] < q1 - 1.5 * iqr || samples[i] > q3 + 1.5 * iqr)
+				outliers.push_back(i);
+	}
+
+	// Linear interpolation between the closest ranks; `sorted` must be sorted!
+	static double percentile(const vector<double>& sorted, double p)
+	{
+		if (sorted.empty()) return 0;
+		double pos = (sorted.size() - 1) * p / 100;
+		auto lo = (size_t)pos;
+		if (lo + 1 >= sorted.size()) return sorted.back();
+		return sorted[lo] + (pos - lo) * (sorted[lo + 1] - sorted[lo]);
+	}
+
+	// Text histogram of the samples (bins of equal width between min and max),
+	// with the bin boundaries passed through `scale` (e.g. for unit conversion):
+	template <typename ScaleF>
+	string histogram(const vector<double>& samples, ScaleF scale, unsigned width = 40) const
+	{
+		if (n < 2 || max == min) return "";
+
+		auto bins = std::min<size_t>(20, (size_t)ceil(log2((double)n)) + 1); // Sturges
+		vector<size_t> counts(bins);
+		auto binwidth = (max - min) / bins;
+		for (auto x : samples)
+			++counts[std::min(bins - 1, (size_t)((x - min) / binwidth))];
+		auto peak = *max_element(counts.begin(), counts.end());
+
+		ostringstream out;
+		for (size_t b = 0; b < bins; ++b) {
+			out << "  [" << setw(10) << scale(min + b * binwidth) << ", "
+			             << setw(10) << scale(min + (b + 1) * binwidth) << (b == bins - 1 ? "] " : ") ")
+			    << string(counts[b] * width / peak, '#')
+			    << (counts[b] ? " " + to_string(counts[b]) : "") << '\n';
 		}
-	};
+		return out.str();
+	}
+};
 
-	//----------------------------------------------------------------------------
-	static bool run(string_view cmdline, int* exitcode = nullptr, DWORD* w32_error = nullptr)
-	//
-	// Returns true if a new process for cmdline was successfully created,
-	// regardless of whether the command itself succeeded or not.
-	// Use the optional out args. to check the actual results.
-	//
-	//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+struct Welch // Welch's t-test (unequal variances): CI of the difference of two means
+//----------------------------------------------------------------------------
+{
+	double diff = 0;   // b.mean - a.mean
+	double lo = 0, hi = 0; // 95% confidence interval of diff
+	double df = 0;     // Welch-Satterthwaite degrees of freedom
+	bool valid = false; // Both sides have at least 2 samples (else there's no CI, and nothing is significant)
+
+	Welch(const Stats& a, const Stats& b)
 	{
-		if (cmdline.empty()) return false;
+		diff = b.mean - a.mean;
+		lo = -INFINITY; hi = INFINITY;
+		if (a.n < 2 || b.n < 2) return;
+		valid = true;
+		double va = a.stddev * a.stddev / a.n, vb = b.stddev * b.stddev / b.n;
+		double se = sqrt(va + vb);
+		df = (va + vb) * (va + vb)
+		   / ((va * va) / (a.n - 1) + (vb * vb) / (b.n - 1));
+		if (!isfinite(df)) df = double(a.n + b.n - 2); // (Both stddevs were 0.)
+		lo = diff - t975(df) * se;
+		hi = diff + t975(df) * se;
+	}
 
-		STARTUPINFOA si = {sizeof(si)};
-		PROCESS_INFORMATION pi;
+	bool significant() const { return valid && (lo > 0 || hi < 0); }
 
-		string cmdline_writable(cmdline);
-		if (!CreateProcessA(NULL, &cmdline_writable[0], NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi)) {
-			auto lasterr = GetLastError();
-			if (w32_error) {
-				*w32_error = lasterr;
-			} else {
-				cerr << "- CreateProcess failed (LastError: " << lasterr << ")!" << endl;
+	// Two-sided 95% critical value of Student's t distribution
+	static double t975(double df)
+	{
+		static const double table[] = { // df = 1..30
+			12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+			 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+			 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+		if (df < 1) return table[0];
+		if (df <= 30) return table[(size_t)df - 1];
+		// Beyond that it's close enough to interpolate linearly in 1/df:
+		static const double tail[][2] = { {30, 2.042}, {40, 2.021}, {60, 2.000}, {120, 1.980} };
+		for (size_t i = 1; i < size(tail); ++i)
+			if (df <= tail[i][0]) {
+				auto x = (1/tail[i-1][0] - 1/df) / (1/tail[i-1][0] - 1/tail[i][0]);
+				return tail[i-1][1] + x * (tail[i][1] - tail[i-1][1]);
 			}
-			return false;
-		}
+		return 1.980 + (1.960 - 1.980) * (1 - 120 / df);
+	}
+};
+
+//----------------------------------------------------------------------------
+struct Complexity // Least-squares fits of t = a + c * f(n), for common f()s
+//----------------------------------------------------------------------------
+// As O(1) is nested in all the others, one with an extra parameter would
+// always fit noise a bit better, so a model only counts if its c is positive,
+// and significantly so (t-test of the slope, at 95%); otherwise it's O(1).
+// If another counting model fits about as well (its AIC is within 2 of the
+// best; they all have the same number of parameters), it's inconclusive.
+//----------------------------------------------------------------------------
+{
+	enum Model { O_1, O_LOG_N, O_N, O_N_LOG_N, O_N2, MODELS };
+	static constexpr const char* Names[MODELS] = { "O(1)", "O(log n)", "O(n)", "O(n log n)", "O(n^2)" };
 
-		WaitForSingleObject(pi.hProcess, INFINITE);
+	struct Fit {
+		double a = 0, c = 0; // (The constant term absorbs e.g. the launch overhead.)
+		double rms = INFINITY; // Residuals, relative to the mean of t; inf: no fit (e.g. c <= 0)
+		double sse = INFINITY; // Sum of the squared residuals
+		bool significant = false; // c > 0, significantly (always true for O(1))
+	} fits[MODELS];
+	Model best = O_1;
+	Model runner_up = O_1; // If inconclusive: the other model fitting about as well
+	bool inconclusive = false;
 
-		if (exitcode) {
-			DWORD w32_exitcode;
-			GetExitCodeProcess(pi.hProcess, &w32_exitcode);
-			*exitcode = (int)w32_exitcode;
+	static double f(Model m, double n)
+	{
+		n = std::max(n, 1.0); // (Allowing n = 0 for the logs.)
+		switch (m) {
+		case O_LOG_N:   return log2(n);
+		case O_N:       return n;
+		case O_N_LOG_N: return n * log2(n);
+		case O_N2:      return n * n;
+		default:        return 1;
 		}
+	}
 
-		CloseHandle(pi.hProcess);
-		CloseHandle(pi.hThread);
+	Complexity(const vector<double>& n, const vector<double>& t)
+	{
+		auto count = (double)t.size();
+		if (count < 3) return; // (Nothing to test the slopes with.)
+		double t_mean = 0;
+		for (auto x : t) t_mean += x / count;
 
-		return true;
+		for (int m = 0; m < MODELS; ++m) {
+			auto& fit = fits[m];
+			double sxx = 0;
+			if (m == O_1) {
+				fit.a = t_mean;
+			} else {
+				double f_mean = 0, sxy = 0;
+				for (size_t i = 0; i < t.size(); ++i) f_mean += f(Model(m), n[i]) / count;
+				for (size_t i = 0; i < t.size(); ++i) {
+					auto dx = f(Model(m), n[i]) - f_mean;
+					sxy += dx * (t[i] - t_mean);
+					sxx += dx * dx;
+				}
+				if (sxx <= 0 || sxy <= 0) continue; // (Getting faster with larger n is not a fit.)
+				fit.c = sxy / sxx;
+				fit.a = t_mean - fit.c * f_mean;
+			}
+			fit.sse = 0;
+			for (size_t i = 0; i < t.size(); ++i) {
+				auto r = t[i] - (fit.a + fit.c * f(Model(m), n[i]));
+				fit.sse += r * r;
+			}
+			fit.rms = t_mean > 0 ? sqrt(fit.sse / count) / t_mean : 0;
+			if (m == O_1) { fit.significant = true; continue; }
+			auto se_c = sqrt(fit.sse / (count - 2) / sxx);
+			fit.significant = se_c == 0 || fit.c / se_c > Welch::t975(count - 2);
+		}
+
+		// The best of the models that count, and whether another one is as good:
+		auto aic_diff = [&](Model a, Model b) { // AIC(b) - AIC(a), for the same number of params
+			if (fits[a].sse <= 0) return fits[b].sse <= 0 ? 0.0 : INFINITY;
+			return count * log(fits[b].sse / fits[a].sse); };
+		for (int m = O_LOG_N; m < MODELS; ++m)
+			if (fits[m].significant && (best == O_1 || fits[m].sse < fits[best].sse)) best = Model(m);
+		for (int m = O_LOG_N; m < MODELS; ++m)
+			if (m != best && fits[m].significant && best != O_1 && aic_diff(best, Model(m)) < 2) {
+				inconclusive = true;
+				runner_up = Model(m);
+				break;
+			}
 	}
-} // namespace sys
+};
+
 
 //----------------------------------------------------------------------------
 class CmdLine
@@ -171,16 +504,24 @@ class CmdLine
 //----------------------------------------------------------------------------
 {
 public:
-	static string quote(const string& arg) { return escape_win32(arg); } //!! Quote AND escape then, actually...
+	static string quote(string_view arg) { return escape_win32(arg); } //!! Quote AND escape then, actually...
 
-	static string escape_win32(const string& arg)
+	static string escape_win32(string_view arg)
+	{
+		string escaped;
+		append_escaped(escaped, arg);
+		return escaped;
+	}
+
+	static void append_escaped(string& escaped, string_view arg) // Appends escape_win32(arg)
 	// Written by Claude 3.5 Sonnet; reviewed by ChatGPT 4o... Only tested with spaces!
 	{
-		if (arg.find_first_of(" \t\n\v\"") == string::npos) {
-			return arg;
+		if (!arg.empty() && arg.find_first_of(" \t\n\v\"") == string_view::npos) { // (Don't lose empty args!)
+			escaped += arg;
+			return;
 		}
 
-		string escaped = "\"";
+		escaped.push_back('"');
 		for (auto it = arg.begin(); ; ++it) {
 			unsigned backslashes = 0;
 			while (it != arg.end() && *it == '\\') {
@@ -200,152 +541,4014 @@ public:
 			}
 		}
 		escaped.push_back('"');
-		return escaped;
 	}
 
-	static string build(char const* const* argv, int argc)
+	template <class It> // (Of anything convertible to string_view)
+	static string build(It first, It last)
+	// In one pass, into a pre-sized string (only escaping can still grow it),
+	// as there can be tens of thousands of args (e.g. from a response file).
 	{
-		vector<string> args(argv, argv + argc);
+		size_t size = 0;
+		for (auto it = first; it != last; ++it) size += string_view(*it).size() + 3; // (+ space & quotes)
 		string cmdline;
-		for (const auto& arg : args) {
-			if (!cmdline.empty()) cmdline += ' ';
-			cmdline += escape_win32(arg);
+		cmdline.reserve(size);
+		for (auto it = first; it != last; ++it) {
+			if (it != first) cmdline += ' ';
+			append_escaped(cmdline, *it);
 		}
 		return cmdline;
 	}
-}; // class cmdline
 
+	static string build(char const* const* argv, int argc) { return build(argv, argv + argc); }
+	static string build(const vector<string>& args) { return build(args.begin(), args.end()); }
 
-//============================================================================
-// Main...
-//============================================================================
+	static vector<string> split(string_view cmdline)
+	// The inverse of build(): tokenize a command line using the same rules as
+	// the MS C runtime (i.e. what escape_win32() was written against), so that
+	// the POSIX backend can get its argv back, verbatim.
+	{
+		vector<string> args;
+		auto it = cmdline.begin(), end = cmdline.end();
+		for (;;) {
+			while (it != end && (*it == ' ' || *it == '\t')) ++it;
+			if (it == end) break;
 
-Timer bailout_timer(Timer::Start);
-auto& normal_out = cfg.Results_To_Stdout ? cout : cerr;
+			string arg;
+			bool quoted = false;
+			while (it != end) {
+				unsigned backslashes = 0;
+				while (it != end && *it == '\\') {
+					++it;
+					++backslashes;
+				}
 
-int main(int argc, char* argv[], [[maybe_unused]] char* envp[])
+				if (it != end && *it == '"') {
+					arg.append(backslashes / 2, '\\');
+					if (backslashes % 2) {       // \" -> literal "
+						arg.push_back('"');
+					} else if (quoted && it + 1 != end && it[1] == '"') { // "" inside quotes -> literal "
+						arg.push_back('"');
+						++it;
+					} else {
+						quoted = !quoted;
+					}
+					++it;
+				} else {
+					arg.append(backslashes, '\\');
+					if (it == end || (!quoted && (*it == ' ' || *it == '\t')))
+						break;
+					arg.push_back(*it++);
+				}
+			}
+			args.push_back(std::move(arg));
+		}
+		return args;
+	}
+}; // class cmdline
+
+
+//----------------------------------------------------------------------------
+class WorkPool // Work-stealing thread pool for a fixed set of tasks
+//----------------------------------------------------------------------------
+// Usage:
+//	WorkPool(n_workers).run(n_tasks, [&](size_t task, unsigned worker) {...});
+//
+// The tasks are dealt round-robin into per-worker queues upfront; each worker
+// takes from the front of its own, and steals from the back of the others'
+// when that's empty. (No new tasks can appear, so it's done when all are.)
+//----------------------------------------------------------------------------
 {
-	// Set the console to UTF-8 (to be restored on exit)
-	//!! Doesn't seem to help, though, in certain (common?) scenarios! :-/
-	//!! Eg. I can `echo ŐŰ` just fine directly, but passing that to `cmd /c`
-	//!! would still strip the accents, no matter what!... :-o
-	sys::ConsoleCP set(CP_UTF8);
+	struct Queue { mutex lock; deque<size_t> tasks; };
+	vector<Queue> queues_;
 
-//	Args args(argc, argv);
+	bool next(unsigned worker, size_t* task)
+	{
+		for (size_t i = 0; i < queues_.size(); ++i) {
+			auto& q = queues_[(worker + i) % queues_.size()];
+			lock_guard guard(q.lock);
+			if (q.tasks.empty()) continue;
+			if (i == 0) { *task = q.tasks.front(); q.tasks.pop_front(); } // Own
+			else        { *task = q.tasks.back();  q.tasks.pop_back(); }  // Stolen
+			return true;
+		}
+		return false;
+	}
 
-	if (argc < 2) {
-		cerr
-			<< TOOLNAME << " version " << VERSION
-			<< " (" << sys::BitArchTag() << "-bit)"
-			<< " -> https://github.com/x1ab/wtime"
-			<< '\n'
-			<< "Usage: " << TOOLNAME << " exename [args...]\n"
-			<< R"(
-Notes:
+public:
+	WorkPool(unsigned workers) : queues_(std::max(1u, workers)) {}
+	unsigned size() const { return (unsigned)queues_.size(); }
 
-  - `exename` must be a standalone executable. (Shell built-ins can be run
-    with explicit shell commands like: `wtime cmd /c echo OK`.)
+	template <typename F>
+	void run(size_t tasks, F&& task)
+	{
+		for (size_t i = 0; i < tasks; ++i) queues_[i % queues_.size()].tasks.push_back(i);
+		vector<thread> threads;
+		for (unsigned w = 0; w < size(); ++w) {
+			threads.emplace_back([&, w] {
+				size_t t;
+				while (next(w, &t)) task(t, w);
+			});
+		}
+		for (auto& th : threads) th.join();
+	}
+};
 
-    Batch files can be run directly (well, obviously still invoking CMD for
-    them). The .cmd or .bat extension can be omitted, just like the .exe
-    (or .com) of real binaries.
 
-  - Quotes around parameters with spaces will be preserved. (Unlike the default
-    behavior on Windows; so no need for e.g. the mildly perverted triple-quote
-    syntax with CMD, like `wtime busybox cat """one two.txt"""`).
+//----------------------------------------------------------------------------
+namespace sys
+//----------------------------------------------------------------------------
+{
+	//----------------------------------------------------------------------------
+	// Detect if this is 32 or 64 bit build
+	//----------------------------------------------------------------------------
+	template <unsigned> unsigned    BitArch();
+	template <>         unsigned    BitArch<4u>() { return 32; }
+	template <>         unsigned    BitArch<8u>() { return 64; }
+	inline const char* BitArchTag()  { return BitArch<sizeof(size_t)>() == 32 ? "32" : "64"; }
 
-    There's also support for quoting (and honoring) escaped special chars using
-    Win32's \ syntax (not the ^ syntax of CMD, sorry!), but for anything more
-    complex, or if you find yourself stuck fighting this, honestly, call 911.
+	const char* OSTag =
+#if   defined(_WIN32)
+		"windows";
+#elif defined(__linux__)
+		"linux";
+#elif defined(__APPLE__)
+		"macos";
+#else
+		"posix";
+#endif
 
-  - Wildcards are not expanded.
+	inline string self_path(const char* argv0) // (argv0 is just a fallback)
+	{
+#ifdef _WIN32
+		char buf[MAX_PATH];
+		if (auto len = GetModuleFileNameA(NULL, buf, MAX_PATH); len && len < MAX_PATH) return buf;
+#elif defined(__linux__)
+		char buf[4096];
+		if (auto len = readlink("/proc/self/exe", buf, sizeof(buf) - 1); len > 0) return string(buf, (size_t)len);
+#endif
+		return argv0;
+	}
 
-)";
+#ifndef _WIN32
+	inline string process_name(pid_t pid)
+	{
+		char path[64];
+		snprintf(path, sizeof(path), "/proc/%d/comm", (int)pid);
+		ifstream file(path);
+		string name;
+		getline(file, name);
+		return name;
+	}
+#endif
 
-		cerr	<< "(BTW, just for the fun of it: printing this took "
-			<< bailout_timer.elapsed() * 1000
-			<< " milliseconds.)\n";
+#ifdef __linux__
+	// All the processes under root (not incl. itself), from the children lists
+	// in /proc/<pid>/task/<tid>/children, or if the kernel doesn't have those,
+	// from the parent pids of all the processes. (Just a snapshot, of course.)
+	inline vector<pid_t> descendants(pid_t root)
+	{
+		static const bool have_children = access("/proc/thread-self/children", R_OK) == 0;
+		auto read_file = [](const char* path) {
+			string text;
+			if (int fd = open(path, O_RDONLY | O_CLOEXEC); fd >= 0) {
+				char buf[4096];
+				for (ssize_t len; (len = read(fd, buf, sizeof(buf))) > 0; ) text.append(buf, (size_t)len);
+				close(fd);
+			}
+			return text;
+		};
+		char path[64];
+		vector<pid_t> found = {root};
+		if (have_children) {
+			for (size_t i = 0; i < found.size(); ++i) {
+				snprintf(path, sizeof(path), "/proc/%d/task", (int)found[i]);
+				DIR* dir = opendir(path);
+				if (!dir) continue; // (Gone already)
+				while (auto entry = readdir(dir)) {
+					if (!isdigit((unsigned char)entry->d_name[0])) continue;
+					snprintf(path, sizeof(path), "/proc/%d/task/%.20s/children", (int)found[i], entry->d_name);
+					auto text = read_file(path);
+					for (char *p = text.data(), *end; ; p = end) {
+						auto pid = strtol(p, &end, 10);
+						if (end == p) break;
+						found.push_back((pid_t)pid);
+					}
+				}
+				closedir(dir);
+			}
+		} else {
+			multimap<pid_t, pid_t> children; // By parent
+			if (DIR* dir = opendir("/proc")) {
+				while (auto entry = readdir(dir)) {
+					if (!isdigit((unsigned char)entry->d_name[0])) continue;
+					snprintf(path, sizeof(path), "/proc/%.20s/stat", entry->d_name);
+					auto text = read_file(path); // "pid (name) state ppid ..."
+					auto close_paren = text.rfind(')');
+					int ppid;
+					if (close_paren != string::npos && sscanf(text.c_str() + close_paren + 1, " %*c %d", &ppid) == 1)
+						children.emplace((pid_t)ppid, (pid_t)atoi(entry->d_name));
+				}
+				closedir(dir);
+			}
+			for (size_t i = 0; i < found.size(); ++i) {
+				auto [first, last] = children.equal_range(found[i]);
+				for (auto it = first; it != last; ++it) found.push_back(it->second);
+			}
+		}
+		found.erase(found.begin());
+		return found;
+	}
+#endif
 
-		return -1;
+	inline string hostname()
+	{
+		char name[256] = "";
+#ifdef _WIN32
+		DWORD size = sizeof(name);
+		if (!GetComputerNameA(name, &size)) return "";
+#else
+		if (gethostname(name, sizeof(name) - 1)) return "";
+#endif
+		return name;
 	}
 
-	++argv; --argc; //!! shift
+#ifdef _WIN32
+	using syserr_t = DWORD;
+	const syserr_t ERR_NOT_FOUND = ERROR_FILE_NOT_FOUND;
 
-	// Save with the original case for reporting:
-	const string child_exe_original_case = argv[0]; assert(!child_exe_original.empty());
-	// ...and convert to lowercase for later processing (yeah, without std::transform...):
-	string child_exe_original_tmp = child_exe_original_case;
-	for (char& c : child_exe_original_tmp)
-		c = (char)std::tolower((unsigned char)c); //! For that sad casts: -> https://en.cppreference.com/w/cpp/string/byte/tolower
-	const string child_exe_original = child_exe_original_tmp;
+	//----------------------------------------------------------------------------
+	class ConsoleCP // RAII wrapper around setting/restoring the console code-page
+	//----------------------------------------------------------------------------
+	{
+		UINT originalCP;
+		UINT originalOutputCP;
 
-	string child_exe_escaped = CmdLine::quote(child_exe_original); assert(!child_exe_escaped.empty());
-		// Need to manually escape the exe name. (Arg lists from CmdLine::build are escaped implicitly!)
-	++argv; --argc; //!! shift
-	string child_args = CmdLine::build(argv, argc); //!! Add this feature to Args!
+	public:
+		ConsoleCP(UINT newCP) {
+			originalCP = GetConsoleCP(); // input CP
+			originalOutputCP = GetConsoleOutputCP();
+			SetConsoleCP(newCP);
+			SetConsoleOutputCP(newCP);
+		}
 
-	int child_exitcode; DWORD win32_error;
-	Timer timer(cfg.Report_Time_Unit);
-
-	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-	// Retry support to amend the shortomings of run() (i.e. CreateProcess) -> #2...
-	// Only an omitted ".exe" would be covered transparently by run.
-	//!! Not adding the retry feature directly to run itself, to keep the timing closer to a clean run.
-	//!! Quick measurements with explicit paths showed no difference, but repeated PATH lookups might!
-	const string retry_with[] = {".com", ".bat", ".cmd"}; // REVERSE order of preference!
-	auto retry = child_exe_original.ends_with(".exe") ? // Don't retry if it's an .exe!
-	                0 : sizeof(retry_with)/sizeof(decltype(retry_with[0]));
-	// Also don't retry if already has any of those extensions, or .exe:
-	for (const auto& ext : retry_with)
-		if (child_exe_original.ends_with(ext))
-			retry = 0;
-do_try:
-	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-
-	string cmdline = child_exe_escaped + " " + child_args;
-	if (cfg.Verbose) normal_out << "Executing: " << cmdline <<"...\n";
+		~ConsoleCP() {
+			SetConsoleCP(originalCP);
+			SetConsoleOutputCP(originalOutputCP);
+		}
+	};
+#else
+	using syserr_t = int; // errno
+	const syserr_t ERR_NOT_FOUND = ENOENT;
+#endif
 
-	timer.start();
-	bool run_succeeded = sys::run(cmdline, &child_exitcode, &win32_error);
-	timer.stop();
+	//----------------------------------------------------------------------------
+	// Performance counters (Linux only)
+	//----------------------------------------------------------------------------
+	enum Counter { CYCLES, INSTRUCTIONS, CACHE_REFS, CACHE_MISSES, BRANCH_MISSES, TASK_CLOCK, COUNTERS };
+	const char* CounterNames[COUNTERS] = {
+		"cycles", "instructions", "cache-references", "cache-misses", "branch-misses", "task-clock" };
 
-	if (run_succeeded) {
-		normal_out
-			<< "Elapsed time: " << timer.elapsed()
-			<< ' ' << cfg.Report_Time_Unit
-			<< '\n';
+	enum Limit { NO_LIMIT, TIMEOUT, MAX_MEM, MAX_CPU };
+	const char* LimitNames[] = { "", "timeout", "max-mem", "max-cpu" }; // (As the options)
 
-		return child_exitcode;
-	}
+	//----------------------------------------------------------------------------
+	struct RunResult
+	//----------------------------------------------------------------------------
+	{
+		int      exitcode = 0;
+		double   wall = 0;         // s
+		double   user = 0;         // s, CPU time spent in user mode
+		double   sys  = 0;         // s, CPU time spent in the kernel
+		double   cpu  = 0;         // s, CPU time of the process itself, by its own CPU clock
+		                           // (Linux, Windows; elsewhere it's user + sys, incl. its children)
+		int64_t  output_bytes = -1; // Written to stdout & stderr (RunOptions::COUNT, TO_FILE; else -1)
+		double   first_output = -1; // s, since the launch, if RunOptions::until_output (-1: none)
+		double   first_match = -1;  // s, since the launch, if RunOptions::until_match (-1: none)
+		bool     killed = false;    // Stopped by us at the milestone (with exit code 0, then)
+		Limit    limit = NO_LIMIT;  // Killed (with its whole tree) at this limit (the rest is partial then)
+		vector<pair<string, double>> marks; // Phase markers (RunOptions::markers): name, s since the launch
+		string controls;            // The noise controls applied (e.g. "cpus=2,3 priority=high aslr=off env=4096")
+		uint64_t max_rss = 0;      // KB (peak working set on Windows; with the tree, see max_rss_of())
+		uint64_t major_faults = 0; // (Windows: not available separately)
+		uint64_t minor_faults = 0; // (Windows: all page faults, soft or hard)
+		uint64_t vol_ctxsw = 0;    // (Windows: not available)
+		uint64_t invol_ctxsw = 0;  // (Windows: not available)
+		int64_t  counters[COUNTERS] = {-1, -1, -1, -1, -1, -1}; // -1: not available (task-clock: ns)
+		unsigned mem_samples = 0;  // Memory sampling (--mem-sample); the rest is valid only if > 0
+		uint64_t mem_peak = 0;     // KB, peak of the sampled RSS
+		double   mem_peak_time = 0;// s, since the launch
+		uint64_t mem_avg = 0;      // KB, average of the sampled RSS
+		uint64_t pss_peak = 0;     // KB (Linux only)
+		uint64_t swap_peak = 0;    // KB (Linux only)
+		unsigned thread_samples = 0; // Thread sampling (--thread-sample); the rest is valid only if > 0
+		double   parallelism_peak = 0; // Highest CPU time / elapsed time in a sampling interval
+		struct ThreadInfo { uint64_t tid = 0; string name; double cpu = 0; }; // (cpu: s; no names on Windows)
+		vector<ThreadInfo> threads; // All the threads seen (of the child process itself), busiest first
 
-	// Errors...
+		// Process tree accounting (RunOptions::tree): the totals above are then for
+		// the whole tree, and this is the breakdown (the processes reaped by us on
+		// Linux, i.e. the child and the orphans; the rest are included in the totals
+		// of their parents), or all the processes seen in the job on Windows:
+		struct ProcessInfo { uint64_t pid = 0; string name; double user = 0, sys = 0; uint64_t max_rss = 0; };
+		vector<ProcessInfo> processes;
+		unsigned tree_processes = 0; // (Windows: all of them, even if not in the breakdown)
 
-	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-	// Rertry with default extensions if not found?
-	if (win32_error == ERROR_FILE_NOT_FOUND && retry) {
-		--retry;
-		// Append the next missing ext. for a(nother) try:
-		child_exe_escaped = CmdLine::quote(child_exe_original + retry_with[retry]);
-		goto do_try;
-	}
-	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+		const char* max_rss_of() const // What max_rss is, as it's not a total for the tree
+		{
+			if (!tree_processes) return "process";
+#ifdef _WIN32
+			return "committed, whole tree";
+#else
+			return "max of any process";
+#endif
+		}
+	};
 
-	// Report the error
-	cerr << "- Failed to run \""<< child_exe_original_case <<"\": ";
-	switch (win32_error) {
-		case ERROR_FILE_NOT_FOUND: cerr << "file not found"; break;
-		case ERROR_PATH_NOT_FOUND: cerr << "path not found"; break;
-		case ERROR_ACCESS_DENIED: cerr << "access denied"; break;
-		case ERROR_INVALID_EXE_SIGNATURE:
-		case ERROR_EXE_MARKED_INVALID:
-		case ERROR_BAD_EXE_FORMAT:
-		case ERROR_EXE_MACHINE_TYPE_MISMATCH:
-		case ERROR_BAD_FORMAT: cerr << "invalid file type/format"; break;
-		case ERROR_NOT_ENOUGH_MEMORY:
-		case ERROR_OUTOFMEMORY: cerr << "not enough memory"; break;
-		default: cerr << "unknown error: " << win32_error << ")";
-	}
-	cerr << "!\n";
+	//----------------------------------------------------------------------------
+	struct Process // A running child, as seen by the monitors
+	//----------------------------------------------------------------------------
+	{
+#ifdef _WIN32
+		HANDLE handle;
+		DWORD  pid;
+#else
+		pid_t  pid;
+#endif
+	};
+
+	//----------------------------------------------------------------------------
+	struct Monitor // Something to watch a child process with, while it's running
+	//----------------------------------------------------------------------------
+	{
+		virtual ~Monitor() = default;
+		virtual void prepare() {}                 // Before the launch (not timed)
+		virtual void started(const Process&) = 0; // Right after the launch (timed, so be quick!)
+		virtual void finished(RunResult&) = 0;    // After it has exited (or failed to launch);
+		                                          // not timed, and before it's reaped on POSIX
+	};
+
+	//----------------------------------------------------------------------------
+	struct RunOptions
+	//----------------------------------------------------------------------------
+	{
+		bool counters = false;     // Collect the performance counters, too
+		bool tree = false;         // Wait for, and account, all the descendants, too
+		// Noise controls (see RunResult::controls for the ones actually applied):
+		vector<unsigned> cpus;     // Pin the child to these CPUs (Linux and Windows only)
+		bool high_priority = false; // Raise its priority (class)
+		bool no_aslr = false;      // Disable its address space randomization (Linux, macOS)
+		size_t env_size = 0;       // Pad its environment to this many bytes (stack alignment!)
+		// Limits (0: none), to kill the child (and its whole tree) at:
+		double timeout = 0;        // s, elapsed
+		uint64_t max_mem = 0;      // KB (RSS on Linux (of the tree, with `tree`), committed memory of the job on Windows)
+		double max_cpu = 0;        // s, CPU time (user + sys; of the whole job on Windows)
+		enum Output { INHERIT, DISCARD, COUNT, TO_FILE }
+		    output = INHERIT;      // Where the child's stdout & stderr go
+		string output_file;        // (For TO_FILE)
+		// Milestones, watching the output (stdout & stderr; not with TO_FILE):
+		bool until_output = false;         // Note when the first byte of output arrives
+		optional<regex> until_match;       // Note when the output first matches this
+		bool kill_at_milestone = false;    // ...and then kill the child
+		bool markers = false;              // Collect phase markers from the child (see PhaseMarkers)
+		vector<Monitor*> monitors; // (Not owned)
+	};
+
+	//----------------------------------------------------------------------------
+	static string env_padding(size_t env_bytes, size_t target) // Variable to add, to get there ("": none)
+	//----------------------------------------------------------------------------
+	{
+		static const string name = "WTIME_ENV_PAD=";
+		if (env_bytes + name.size() + 1 > target) return "";
+		return name + string(target - env_bytes - name.size() - 1, 'x');
+	}
+
+	static string cpu_list(const vector<unsigned>& cpus) // For RunResult::controls
+	{
+		string list;
+		for (auto c : cpus) list += (list.empty() ? "" : ",") + to_string(c);
+		return list;
+	}
+
+	//----------------------------------------------------------------------------
+	static bool find_executable(const string& name, string* path)
+	//
+	// Look up the executable file for `name` like launching it would (i.e. with
+	// the search order of CreateProcess + PATHEXT on Windows, or PATH + exec.
+	// permission on POSIX), so the timed launch can use it directly, without
+	// searching. The results are cached for the session.
+	//
+	//----------------------------------------------------------------------------
+	{
+		static map<string, string> cache; // "" for not found
+		static mutex cache_lock;
+		lock_guard lock(cache_lock);
+		if (auto it = cache.find(name); it != cache.end()) {
+			*path = it->second;
+			return !path->empty();
+		}
+		auto& found = cache[name];
+
+#ifdef _WIN32
+		auto is_file = [](const string& p) { auto attr = GetFileAttributesA(p.c_str());
+			return attr != INVALID_FILE_ATTRIBUTES && !(attr & FILE_ATTRIBUTE_DIRECTORY); };
+
+		auto basename_at = name.find_last_of("\\/:");
+		vector<string> exts;
+		if (name.find('.', basename_at == string::npos ? 0 : basename_at + 1) != string::npos)
+			exts.push_back(""); // Try as-is first, if it has an extension
+		const char* pathext = getenv("PATHEXT");
+		istringstream pathexts(pathext && *pathext ? pathext : ".COM;.EXE;.BAT;.CMD");
+		for (string ext; getline(pathexts, ext, ';'); )
+			if (!ext.empty()) exts.push_back(ext);
+
+		vector<string> dirs;
+		if (basename_at != string::npos) {
+			dirs.push_back(""); // Has a path already, no searching
+		} else {
+			char buf[MAX_PATH];
+			if (auto len = GetModuleFileNameA(NULL, buf, MAX_PATH); len && len < MAX_PATH) {
+				string self(buf); dirs.push_back(self.substr(0, self.find_last_of("\\/") + 1));
+			}
+			dirs.push_back(""); // Current dir.
+			if (GetSystemDirectoryA(buf, MAX_PATH))  dirs.push_back(string(buf) + "\\");
+			if (GetWindowsDirectoryA(buf, MAX_PATH)) dirs.push_back(string(buf) + "\\");
+			const char* env_path = getenv("PATH");
+			istringstream paths(env_path ? env_path : "");
+			for (string dir; getline(paths, dir, ';'); ) {
+				if (dir.size() >= 2 && dir.front() == '"' && dir.back() == '"') dir = dir.substr(1, dir.size() - 2);
+				if (dir.empty()) continue;
+				if (dir.back() != '\\' && dir.back() != '/') dir += '\\';
+				dirs.push_back(dir);
+			}
+		}
+
+		for (const auto& dir : dirs)
+			for (const auto& ext : exts)
+				if (auto candidate = dir + name + ext; is_file(candidate)) {
+					char full[MAX_PATH];
+					auto len = GetFullPathNameA(candidate.c_str(), MAX_PATH, full, nullptr);
+					found = len && len < MAX_PATH ? full : candidate;
+					goto done;
+				}
+	done:
+#else
+		if (name.find('/') != string::npos) {
+			found = name; // Has a path already, no searching (and let the launch report any errors)
+		} else {
+			auto is_exe = [](const string& p) { struct stat st;
+				return stat(p.c_str(), &st) == 0 && S_ISREG(st.st_mode) && access(p.c_str(), X_OK) == 0; };
+			const char* env_path = getenv("PATH");
+			istringstream paths(env_path ? env_path : "/usr/local/bin:/usr/bin:/bin");
+			for (string dir; getline(paths, dir, ':'); )
+				if (auto candidate = (dir.empty() ? "." : dir) + "/" + name; is_exe(candidate)) {
+					found = candidate;
+					break;
+				}
+		}
+		// Make it absolute (e.g. for "./tool", or a relative dir in the PATH), but
+		// without resolving symlinks (which could change what argv[0] means to it):
+		if (!found.empty() && found[0] != '/') {
+			char cwd[4096];
+			if (getcwd(cwd, sizeof(cwd)))
+				found = string(cwd) + "/" + (found.starts_with("./") ? found.substr(2) : found);
+		}
+#endif
+		*path = found;
+		return !found.empty();
+	}
+
+#ifndef _WIN32
+	//----------------------------------------------------------------------------
+	static bool needs_shell(const string& path, bool set = false)
+	// Whether the file has been found to be a script without a #! line, which
+	// exec() can't run (ENOEXEC), so it has to be run with /bin/sh, like execvp()
+	// and the shells do. (Remembered, so that's tried only once per file.)
+	//----------------------------------------------------------------------------
+	{
+		static map<string, bool> scripts;
+		static mutex lock;
+		lock_guard guard(lock);
+		if (set) scripts[path] = true;
+		return scripts.count(path) > 0;
+	}
+#endif
+
+	//----------------------------------------------------------------------------
+	class OutputRedirect // The child's stdout & stderr, for RunOptions::output
+	//----------------------------------------------------------------------------
+	// DISCARD: to the null device. COUNT: into a pipe, drained (and counted) by
+	// a thread, with splice() into /dev/null on Linux (so without copying it to
+	// user space). TO_FILE: to a (truncated) file, counted by its size at the end.
+	//
+	// For the milestones (RunOptions::until_*), it also goes into the pipe, but
+	// then it's read, to watch it (and echoed to our stdout, if not redirected).
+	//----------------------------------------------------------------------------
+	{
+	public:
+#ifdef _WIN32
+		using handle_t = HANDLE;
+		static inline const handle_t NONE = INVALID_HANDLE_VALUE;
+#else
+		using handle_t = int;
+		static constexpr handle_t NONE = -1;
+#endif
+
+	private:
+		RunOptions::Output mode_;
+		const RunOptions& options_;
+		bool watch_ = false, echo_ = false, count_ = true;
+		handle_t child_ = NONE; // What the child gets as its stdout & stderr
+		handle_t read_ = NONE;  // Our end of the pipe (COUNT, or watching)
+		thread drain_;
+		atomic<bool> stop_ = false, done_ = false;
+		uint64_t bytes_ = 0;
+#ifdef _WIN32
+		atomic<HANDLE> drain_thread_ = NULL; // (For cancelling its blocking read)
+#endif
+		// Watching:
+		atomic<Timer::time_point::rep> launch_ = 0; // (Clock ticks)
+		atomic<bool> launched_ = false;
+		Process process_ = {};
+#ifdef _WIN32
+		HANDLE job_ = NULL; // (If it's in one: killed as a whole)
+#endif
+		string tail_; // The end of the output so far, for matching
+		double first_output_ = -1, first_match_ = -1;
+		atomic<bool> killed_ = false;
+
+	public:
+		OutputRedirect(const RunOptions& options) : mode_(options.output), options_(options)
+		{
+			watch_ = options.until_output || options.until_match;
+			if (watch_) { // Into the pipe, then:
+				echo_ = mode_ == RunOptions::INHERIT; // (Still showing it)
+				count_ = mode_ == RunOptions::COUNT;
+				mode_ = RunOptions::COUNT;
+			}
+		}
+		~OutputRedirect() { finish(); }
+
+		handle_t child() const { return child_; }
+		bool redirected() const { return mode_ != RunOptions::INHERIT; }
+
+		syserr_t open(const string& path) // Before the launch; returns 0 if OK
+		{
+#ifdef _WIN32
+			SECURITY_ATTRIBUTES inheritable = {sizeof(inheritable), NULL, TRUE};
+			switch (mode_) {
+			case RunOptions::DISCARD:
+				child_ = CreateFileA("NUL", GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, &inheritable, OPEN_EXISTING, 0, NULL);
+				break;
+			case RunOptions::TO_FILE:
+				child_ = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, &inheritable, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+				break;
+			case RunOptions::COUNT:
+				if (!CreatePipe(&read_, &child_, &inheritable, 1 << 20)) { read_ = child_ = NONE; return GetLastError(); }
+				SetHandleInformation(read_, HANDLE_FLAG_INHERIT, 0); // (Only the child's end!)
+				drain_ = thread([this] { drain(); });
+				break;
+			default: return 0;
+			}
+			return child_ == NONE ? GetLastError() : 0;
+#else
+			switch (mode_) {
+			case RunOptions::DISCARD:
+				child_ = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+				break;
+			case RunOptions::TO_FILE:
+				child_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+				break;
+			case RunOptions::COUNT: {
+				// (Close-on-exec, so that other children don't keep the pipe open;
+				// the child's own copies are made by dup2, without that flag.)
+				int fds[2];
+#ifdef __linux__
+				if (pipe2(fds, O_CLOEXEC) < 0) return errno;
+#else
+				if (pipe(fds) < 0) return errno;
+				fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+				fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+				read_ = fds[0];
+				child_ = fds[1];
+				drain_ = thread([this] { drain(); });
+				break; }
+			default: return 0;
+			}
+			return child_ == NONE ? errno : 0;
+#endif
+		}
+
+		void launching(Timer::time_point t) // Right before the launch (the milestones are relative to this)
+		{
+			launch_ = t.time_since_epoch().count();
+		}
+
+		void started(const Process& process) // After the launch: drop our copy of the child's end (except the file's)
+		{
+			process_ = process;
+			launched_ = true;
+			if (mode_ != RunOptions::TO_FILE) close_handle(child_);
+		}
+#ifdef _WIN32
+		void started(const Process& process, HANDLE job)
+		{
+			job_ = job;
+			started(process);
+		}
+#endif
+
+		int64_t finish(RunResult* result = nullptr) // After the child has exited: the bytes written, or -1 if not counted
+		{
+			int64_t bytes = -1;
+			if (mode_ == RunOptions::TO_FILE && child_ != NONE) {
+#ifdef _WIN32
+				LARGE_INTEGER size;
+				if (GetFileSizeEx(child_, &size)) bytes = size.QuadPart;
+#else
+				struct stat st;
+				if (fstat(child_, &st) == 0) bytes = st.st_size;
+#endif
+			}
+			close_handle(child_);
+			if (drain_.joinable()) {
+				stop_ = true;
+#ifdef _WIN32
+				// Give it a moment to see the end of the pipe, but if some leftover
+				// background process still has it open, just stop waiting for it:
+				for (int i = 0; !done_; ++i) {
+					if (i >= 5) if (auto h = drain_thread_.load()) CancelSynchronousIo(h);
+					this_thread::sleep_for(10ms);
+				}
+#endif
+				drain_.join();
+				if (count_) bytes = (int64_t)bytes_;
+			}
+			close_handle(read_);
+			if (result) {
+				result->first_output = first_output_;
+				result->first_match = first_match_;
+			}
+			return bytes;
+		}
+
+		bool killed() const { return killed_; }
+
+	private:
+		static void close_handle(handle_t& h)
+		{
+#ifdef _WIN32
+			if (h != NONE) CloseHandle(h);
+#else
+			if (h != NONE) close(h);
+#endif
+			h = NONE;
+		}
+
+		void watch(const char* data, size_t n) // Check the milestones in the next chunk of the output
+		{
+			auto now = [&] {
+				return Timer::elapsed(Timer::time_point(Clock::duration(launch_.load())), Clock::now()); };
+			bool reached = false;
+			if (first_output_ < 0) {
+				first_output_ = now();
+				reached = options_.until_output;
+			}
+			if (options_.until_match && first_match_ < 0) {
+				// (Keeping only the last 4K of unmatched output: long enough for any
+				// reasonable "ready" message, even if split across the reads.)
+				tail_.append(data, n);
+				if (regex_search(tail_, *options_.until_match)) {
+					first_match_ = now();
+					reached = true;
+				} else if (tail_.size() > 4096) {
+					tail_.erase(0, tail_.size() - 4096);
+				}
+			}
+			if (echo_) {
+#ifdef _WIN32
+				DWORD written;
+				WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), data, (DWORD)n, &written, NULL);
+#else
+				for (size_t done = 0; done < n; ) {
+					auto w = write(STDOUT_FILENO, data + done, n - done);
+					if (w <= 0) break;
+					done += (size_t)w;
+				}
+#endif
+			}
+			if (reached && options_.kill_at_milestone && !killed_) {
+				while (!launched_) this_thread::yield(); // (It can print before we're told its pid.)
+				killed_ = true;
+				// All of it, not just the child (which may well be just a
+				// launcher script), to not leave the rest running:
+#ifdef _WIN32
+				if (!job_ || !TerminateJobObject(job_, 1)) TerminateProcess(process_.handle, 1);
+#else
+				kill(-process_.pid, SIGKILL); // Its group (see run())
+				kill(process_.pid, SIGKILL);  // (In case it failed to get its own group)
+#endif
+			}
+		}
+
+		void drain()
+		{
+			static thread_local char buf[65536];
+#ifdef _WIN32
+			drain_thread_ = OpenThread(THREAD_TERMINATE, FALSE, GetCurrentThreadId());
+			for (;;) {
+				DWORD n = 0;
+				if (ReadFile(read_, buf, sizeof(buf), &n, NULL)) {
+					bytes_ += n;
+					if (watch_ && n) watch(buf, n);
+					continue;
+				}
+				if (GetLastError() != ERROR_OPERATION_ABORTED || !stop_) break; // (Broken pipe: all done)
+				// Cancelled: just take what's there already
+				DWORD avail = 0;
+				while (PeekNamedPipe(read_, NULL, 0, NULL, &avail, NULL) && avail
+				       && ReadFile(read_, buf, std::min<DWORD>(avail, sizeof(buf)), &n, NULL))
+					bytes_ += n;
+				break;
+			}
+			if (auto h = drain_thread_.exchange(NULL)) CloseHandle(h);
+#else
+#  ifdef __linux__
+			int sink = watch_ ? -1 : ::open("/dev/null", O_WRONLY | O_CLOEXEC); // (Must read it to watch it.)
+#  endif
+			for (;;) {
+				// (Polling with a timeout, so we can stop if some leftover background
+				// process still has the pipe open after the child has exited.)
+				pollfd p = {read_, POLLIN, 0};
+				int ready = poll(&p, 1, 50);
+				if (ready < 0 && errno != EINTR) break;
+				if (ready <= 0) { if (stop_) break; continue; }
+				ssize_t n;
+#  ifdef __linux__
+				if (sink >= 0) {
+					n = splice(read_, nullptr, sink, nullptr, 1 << 20, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+					if (n < 0 && errno == EINVAL) { close(sink); sink = -1; continue; } // (Can't splice: read then)
+				} else
+#  endif
+				n = read(read_, buf, sizeof(buf));
+				if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+				if (n <= 0) break; // EOF
+				bytes_ += (uint64_t)n;
+				if (watch_) watch(buf, (size_t)n);
+			}
+#  ifdef __linux__
+			if (sink >= 0) close(sink);
+#  endif
+#endif
+			done_ = true;
+		}
+	};
+
+	//----------------------------------------------------------------------------
+	class PhaseMarkers // Phase markers written by the child, for RunOptions::markers
+	//----------------------------------------------------------------------------
+	// The child gets MARK_ENV in its environment: the fd of a pipe on POSIX
+	// (always MARK_FD, as shells like dash only take single digits), or the path
+	// of a named pipe on Windows. Each line written to that (e.g. "phase:load",
+	// or just "load") starts a new phase, timestamped on arrival. So e.g.:
+	//
+	//	echo phase:load >&$WTIME_MARK_FD    (POSIX shells)
+	//	echo phase:load > %WTIME_MARK_FD%   (CMD)
+	//
+	//----------------------------------------------------------------------------
+	{
+	public:
+		static constexpr const char* MARK_ENV = "WTIME_MARK_FD";
+#ifndef _WIN32
+		static constexpr int MARK_FD = 9;
+#endif
+
+	private:
+		thread reader_;
+		atomic<bool> stop_ = false;
+		atomic<Timer::time_point::rep> launch_ = 0; // (Clock ticks)
+		vector<pair<string, double>> marks_;
+		string partial_; // (Line not yet finished)
+#ifdef _WIN32
+		string pipe_name_;
+		HANDLE pipe_ = INVALID_HANDLE_VALUE;
+#else
+		int read_ = -1, write_ = -1;
+#endif
+
+	public:
+		~PhaseMarkers() { finish(nullptr); }
+
+#ifdef _WIN32
+		string env() const { return string(MARK_ENV) + "=" + pipe_name_; }
+
+		syserr_t open()
+		{
+			static atomic<unsigned> serial = 0;
+			pipe_name_ = "\\\\.\\pipe\\wtime-" + to_string(GetCurrentProcessId()) + "-" + to_string(serial++);
+			// (One client at a time: each `echo ... > pipe` connects anew.)
+			pipe_ = CreateNamedPipeA(pipe_name_.c_str(), PIPE_ACCESS_INBOUND, PIPE_TYPE_BYTE | PIPE_WAIT,
+			                         1, 0, 4096, 0, NULL);
+			if (pipe_ == INVALID_HANDLE_VALUE) return GetLastError();
+			reader_ = thread([this] { read(); });
+			return 0;
+		}
+#else
+		string env() const { return string(MARK_ENV) + "=" + to_string(MARK_FD); }
+		int child() const { return write_; } // (To be dup'ed to MARK_FD)
+
+		syserr_t open()
+		{
+			int fds[2];
+#ifdef __linux__
+			if (pipe2(fds, O_CLOEXEC) < 0) return errno;
+#else
+			if (pipe(fds) < 0) return errno;
+			fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+			fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+			read_ = fds[0];
+			write_ = fds[1];
+			reader_ = thread([this] { read(); });
+			return 0;
+		}
+#endif
+
+		void launching(Timer::time_point t) { launch_ = t.time_since_epoch().count(); }
+
+		void started() // After the launch: drop our copy of the child's end
+		{
+#ifndef _WIN32
+			if (write_ >= 0) { close(write_); write_ = -1; }
+#endif
+		}
+
+		void finish(RunResult* result) // After the child has exited
+		{
+			started(); // (If it hasn't been, yet.)
+			if (reader_.joinable()) {
+				stop_ = true;
+#ifdef _WIN32
+				// Wake it up, if it's waiting for a new client:
+				HANDLE h = CreateFileA(pipe_name_.c_str(), GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+				if (h != INVALID_HANDLE_VALUE) CloseHandle(h);
+#endif
+				reader_.join();
+			}
+#ifdef _WIN32
+			if (pipe_ != INVALID_HANDLE_VALUE) { CloseHandle(pipe_); pipe_ = INVALID_HANDLE_VALUE; }
+#else
+			if (read_ >= 0) { close(read_); read_ = -1; }
+#endif
+			if (result) result->marks = std::move(marks_);
+		}
+
+	private:
+		void add(const char* data, size_t n) // Split into lines, all stamped with the same arrival time
+		{
+			auto t = Timer::elapsed(Timer::time_point(Clock::duration(launch_.load())), Clock::now());
+			partial_.append(data, n);
+			for (size_t eol; (eol = partial_.find('\n')) != string::npos; partial_.erase(0, eol + 1)) {
+				string_view line(partial_.data(), eol);
+				while (!line.empty() && isspace((unsigned char)line.back())) line.remove_suffix(1);
+				if (line.starts_with("phase:")) line.remove_prefix(6);
+				if (!line.empty()) marks_.emplace_back(line, t);
+			}
+		}
+
+		void read()
+		{
+			char buf[4096];
+#ifdef _WIN32
+			while (!stop_) {
+				if (!ConnectNamedPipe(pipe_, NULL) && GetLastError() != ERROR_PIPE_CONNECTED) break;
+				DWORD n;
+				while (ReadFile(pipe_, buf, sizeof(buf), &n, NULL) && n)
+					add(buf, n);
+				DisconnectNamedPipe(pipe_);
+			}
+#else
+			for (;;) {
+				// (Polling with a timeout, so we can stop if some leftover background
+				// process still has the pipe open after the child has exited.)
+				pollfd p = {read_, POLLIN, 0};
+				int ready = poll(&p, 1, 50);
+				if (ready < 0 && errno != EINTR) break;
+				if (ready <= 0) { if (stop_) break; continue; }
+				auto n = ::read(read_, buf, sizeof(buf));
+				if (n < 0 && errno == EINTR) continue;
+				if (n <= 0) break; // EOF
+				add(buf, (size_t)n);
+			}
+#endif
+			if (!partial_.empty()) add("\n", 1); // (Unterminated last line)
+		}
+	};
+
+	//----------------------------------------------------------------------------
+	class PeriodicSampler : public Monitor // The common part of the samplers below
+	//----------------------------------------------------------------------------
+	// A thread started before the launch (not to be timed), then calling sample()
+	// at a fixed rate, counted from the launch, until the child is done.
+	// (Derived classes must stop() it in their destructors, as it calls them.)
+	//----------------------------------------------------------------------------
+	{
+	public:
+		PeriodicSampler(double hz) : hz_(hz) {}
+		~PeriodicSampler() { stop(); }
+
+		double rate() const { return hz_; }
+
+		void prepare() override
+		{
+			interval_ = chrono::duration<double>(1 / hz_);
+			state_ = Waiting;
+			thread_ = thread(&PeriodicSampler::loop_, this);
+		}
+
+		void started(const Process& proc) override
+		{
+			{ lock_guard lock(mutex_); proc_ = proc; start_ = chrono::steady_clock::now(); state_ = Running; }
+			cv_.notify_one();
+		}
+
+	protected:
+		Process proc_ = {};
+		chrono::duration<double> interval_; // (Can be changed by sample().)
+
+		// On the sampling thread:
+		virtual void begin() {}                // Before the first sample
+		virtual void sample(double t) = 0;     // t: s since the launch
+		virtual void end() {}                  // After the last one
+
+		void stop() // Stops the sampling thread (call first in finished())
+		{
+			if (!thread_.joinable()) return;
+			{ lock_guard lock(mutex_); state_ = Done; }
+			cv_.notify_one();
+			thread_.join();
+		}
+
+		double elapsed() const { return chrono::duration<double>(chrono::steady_clock::now() - start_).count(); }
+
+	private:
+		enum State { Waiting, Running, Done };
+
+		double hz_;
+		thread thread_;
+		mutex mutex_;
+		condition_variable cv_;
+		State state_ = Waiting;
+		chrono::steady_clock::time_point start_;
+
+		void loop_()
+		{
+			unique_lock lock(mutex_);
+			cv_.wait(lock, [this]{ return state_ != Waiting; });
+			if (state_ == Done) return; // (Failed to launch.)
+			auto next = start_;
+			lock.unlock();
+
+			begin();
+			for (;;) {
+				sample(elapsed());
+
+				next += chrono::duration_cast<chrono::steady_clock::duration>(interval_);
+				lock.lock();
+				bool done = cv_.wait_until(lock, next, [this]{ return state_ == Done; });
+				lock.unlock();
+				if (done) break;
+			}
+			end();
+		}
+	};
+
+	//----------------------------------------------------------------------------
+	class MemSampler : public PeriodicSampler
+	//----------------------------------------------------------------------------
+	// Samples the memory use of the child from a separate thread, at a fixed
+	// rate (RSS, PSS and swap from /proc/<pid>/smaps_rollup on Linux, or just
+	// the working set on Windows). The timeline is kept in a preallocated
+	// buffer (halving its resolution if it gets full), so the sampling loop
+	// itself doesn't allocate.
+	//----------------------------------------------------------------------------
+	{
+	public:
+		struct Sample { double t; uint64_t rss, pss, swap; }; // s (since the launch), KB
+
+		MemSampler(double hz, size_t capacity = 1 << 16) : PeriodicSampler(hz), samples_(capacity) {}
+		~MemSampler() { stop(); }
+
+		size_t size() const { return count_; } // Of the timeline of the last run
+		const Sample& operator[](size_t i) const { return samples_[i]; }
+
+		void prepare() override
+		{
+			count_ = 0; peak_ = {}; rss_sum_ = 0; n_ = 0;
+			PeriodicSampler::prepare();
+		}
+
+		void finished(RunResult& result) override
+		{
+			stop();
+			result.mem_samples = (unsigned)n_;
+			if (!n_) return;
+			result.mem_peak = peak_.rss;
+			result.mem_peak_time = peak_.t;
+			result.mem_avg = rss_sum_ / n_;
+			result.pss_peak = peak_pss_;
+			result.swap_peak = peak_swap_;
+		}
+
+	private:
+		vector<Sample> samples_;
+		size_t count_ = 0;
+		Sample peak_ = {};
+		uint64_t peak_pss_ = 0, peak_swap_ = 0, rss_sum_ = 0, n_ = 0;
+#ifndef _WIN32
+		char path_[64];
+		int fd_ = -1;
+		bool rollup_ = false;
+#endif
+
+		bool read_(Sample& s)
+		{
+#ifdef _WIN32
+			PROCESS_MEMORY_COUNTERS pmc = {sizeof(pmc)};
+			if (!GetProcessMemoryInfo(proc_.handle, &pmc, sizeof(pmc))) return false;
+			s.rss = pmc.WorkingSetSize / 1024;
+			return true;
+#else
+			static const long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+			char buf[4096];
+			auto len = fd_ < 0 ? -1 : pread(fd_, buf, sizeof(buf) - 1, 0);
+			if (len <= 0) {
+				// The file is bound to the address space it was opened with, which
+				// may have been the pre-exec one (the spawn can return that early),
+				// so try reopening it:
+				if (fd_ >= 0) close(fd_);
+				fd_ = open(path_, O_RDONLY | O_CLOEXEC);
+				len = fd_ < 0 ? -1 : pread(fd_, buf, sizeof(buf) - 1, 0);
+			}
+			if (len <= 0) return false;
+			buf[len] = 0;
+			if (!rollup_) { // statm: size resident shared ... (pages)
+				unsigned long long size, resident;
+				if (sscanf(buf, "%llu %llu", &size, &resident) != 2) return false;
+				s.rss = resident * page_kb;
+				return true;
+			}
+			auto field = [&](const char* name) -> uint64_t {
+				auto p = strstr(buf, name);
+				return p ? strtoull(p + strlen(name), nullptr, 10) : 0; };
+			s.rss  = field("\nRss:");
+			s.pss  = field("\nPss:");
+			s.swap = field("\nSwap:");
+			return true;
+#endif
+		}
+
+		void begin() override
+		{
+#ifndef _WIN32
+			snprintf(path_, sizeof(path_), "/proc/%d/smaps_rollup", (int)proc_.pid);
+			fd_ = open(path_, O_RDONLY | O_CLOEXEC);
+			rollup_ = fd_ >= 0;
+			if (!rollup_) { // (Before Linux 4.14, or not Linux at all...)
+				snprintf(path_, sizeof(path_), "/proc/%d/statm", (int)proc_.pid);
+				fd_ = open(path_, O_RDONLY | O_CLOEXEC);
+			}
+#endif
+		}
+
+		void sample(double t) override
+		{
+			Sample s = {t, 0, 0, 0};
+			if (!read_(s)) return;
+			if (count_ == samples_.size()) { // Full: keep every other one, and slow down
+				for (size_t i = 0; i < count_ / 2; ++i) samples_[i] = samples_[i * 2];
+				count_ /= 2;
+				interval_ *= 2;
+			}
+			samples_[count_++] = s;
+			if (s.rss > peak_.rss) peak_ = s;
+			peak_pss_ = std::max(peak_pss_, s.pss);
+			peak_swap_ = std::max(peak_swap_, s.swap);
+			rss_sum_ += s.rss;
+			++n_;
+		}
+
+		void end() override
+		{
+#ifndef _WIN32
+			if (fd_ >= 0) close(fd_);
+			fd_ = -1;
+#endif
+		}
+	};
+
+	//----------------------------------------------------------------------------
+	class ThreadSampler : public PeriodicSampler
+	//----------------------------------------------------------------------------
+	// Samples the CPU time of each thread of the child from a separate thread,
+	// at a fixed rate (from /proc/<pid>/task/*/schedstat on Linux, or with a
+	// thread snapshot and GetThreadTimes on Windows), for the peak parallelism
+	// (the average is just the CPU time of the process / the elapsed time),
+	// and the busiest threads. (Threads exiting between two samples lose their
+	// CPU time since the previous one, so keep the rate high enough for those.)
+	// Not available elsewhere: it'll just find no threads.
+	//----------------------------------------------------------------------------
+	{
+	public:
+		ThreadSampler(double hz) : PeriodicSampler(hz) {}
+		~ThreadSampler() { stop(); }
+
+		void prepare() override
+		{
+			threads_.clear(); n_ = 0; peak_ = last_t_ = last_cpu_ = 0;
+			PeriodicSampler::prepare();
+		}
+
+		void finished(RunResult& result) override
+		{
+			stop();
+			if (n_) sample(elapsed()); // The final times of the threads still there (POSIX: not reaped yet)
+			result.thread_samples = (unsigned)n_;
+			result.parallelism_peak = peak_;
+			result.threads.clear();
+			for (auto& [tid, t] : threads_) result.threads.push_back(t);
+			sort(result.threads.begin(), result.threads.end(), [](auto& a, auto& b) { return a.cpu > b.cpu; });
+		}
+
+	private:
+		map<uint64_t, RunResult::ThreadInfo> threads_; // By tid
+		uint64_t n_ = 0;
+		double peak_ = 0, last_t_ = 0, last_cpu_ = 0;
+
+		void sample(double t) override
+		{
+			if (auto cpu = read_(); cpu >= 0) {
+				if (n_++ && t > last_t_) peak_ = std::max(peak_, (cpu - last_cpu_) / (t - last_t_));
+				last_t_ = t; last_cpu_ = cpu;
+			}
+		}
+
+		double read_() // Updates the threads, and returns their total CPU time (-1: failed)
+		{
+#ifdef _WIN32
+			HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+			if (snapshot == INVALID_HANDLE_VALUE) return -1;
+			THREADENTRY32 te = {sizeof(te)};
+			for (BOOL ok = Thread32First(snapshot, &te); ok; ok = Thread32Next(snapshot, &te)) {
+				if (te.th32OwnerProcessID != proc_.pid) continue;
+				HANDLE h = OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, te.th32ThreadID);
+				if (!h) continue;
+				FILETIME creation, exit, kernel, user;
+				if (GetThreadTimes(h, &creation, &exit, &kernel, &user)) {
+					auto ticks = [](FILETIME ft) { return double(ULARGE_INTEGER{{ft.dwLowDateTime, ft.dwHighDateTime}}.QuadPart); };
+					auto& t = threads_[te.th32ThreadID];
+					t.tid = te.th32ThreadID;
+					t.cpu = (ticks(user) + ticks(kernel)) / 1e7;
+				}
+				CloseHandle(h);
+			}
+			CloseHandle(snapshot);
+#elif defined(__linux__)
+			char path[64];
+			snprintf(path, sizeof(path), "/proc/%d/task", (int)proc_.pid);
+			DIR* dir = opendir(path);
+			if (!dir) return -1;
+			static const double tick = 1.0 / (double)sysconf(_SC_CLK_TCK);
+			auto read_file = [](const char* path, char* buf, size_t size) {
+				int fd = open(path, O_RDONLY | O_CLOEXEC);
+				if (fd < 0) return false;
+				auto len = read(fd, buf, size - 1);
+				close(fd);
+				if (len <= 0) return false;
+				buf[len] = 0;
+				return true;
+			};
+			while (auto entry = readdir(dir)) {
+				if (!isdigit((unsigned char)entry->d_name[0])) continue;
+				auto tid = strtoull(entry->d_name, nullptr, 10);
+				char buf[512];
+				double cpu = -1;
+				// schedstat: the time on the CPU, in ns (if the kernel has it),
+				// otherwise stat: utime & stime, in clock ticks:
+				snprintf(path, sizeof(path), "/proc/%d/task/%llu/schedstat", (int)proc_.pid, (unsigned long long)tid);
+				unsigned long long ns, utime, stime;
+				if (read_file(path, buf, sizeof(buf)) && sscanf(buf, "%llu", &ns) == 1) cpu = (double)ns / 1e9;
+				snprintf(path, sizeof(path), "/proc/%d/task/%llu/stat", (int)proc_.pid, (unsigned long long)tid);
+				auto it = threads_.find(tid);
+				if (cpu < 0 || it == threads_.end()) { // (Also the name: "tid (name) state ...")
+					if (!read_file(path, buf, sizeof(buf))) continue;
+					auto open_paren = strchr(buf, '('), close_paren = strrchr(buf, ')');
+					if (!open_paren || !close_paren) continue;
+					if (cpu < 0) {
+						if (sscanf(close_paren + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2) continue;
+						cpu = double(utime + stime) * tick;
+					}
+					if (it == threads_.end())
+						it = threads_.emplace(tid, RunResult::ThreadInfo{tid, string(open_paren + 1, close_paren)}).first;
+				}
+				it->second.cpu = cpu;
+			}
+			closedir(dir);
+#endif
+			double total = 0;
+			for (auto& [tid, t] : threads_) total += t.cpu;
+			return total;
+		}
+	};
+
+#ifdef _WIN32
+	//----------------------------------------------------------------------------
+	static bool run(string_view cmdline, RunResult* result = nullptr, syserr_t* w32_error = nullptr, const RunOptions& options = {})
+	//
+	// Returns true if a new process for cmdline was successfully created,
+	// regardless of whether the command itself succeeded or not.
+	// Use the optional out args. to check the actual results.
+	//
+	//----------------------------------------------------------------------------
+	{
+		if (cmdline.empty()) return false;
+
+		// Launch it by its full path, to leave the lookup out of the timing:
+		auto args = CmdLine::split(cmdline);
+		string exe_path;
+		if (args.empty() || !find_executable(args[0], &exe_path)) {
+			if (w32_error) *w32_error = ERROR_FILE_NOT_FOUND;
+			else cerr << "- CreateProcess failed: file not found!" << endl;
+			return false;
+		}
+		args[0] = exe_path;
+		string cmdline_writable = CmdLine::build(args);
+
+		STARTUPINFOEXA six = {};
+		six.StartupInfo.cb = sizeof(six);
+		auto& si = six.StartupInfo;
+		PROCESS_INFORMATION pi;
+
+		RunResult unused;
+		if (!result) result = &unused;
+
+		OutputRedirect output(options);
+		if (auto err = output.open(options.output_file); err) {
+			if (w32_error) *w32_error = err;
+			else cerr << "- Failed to set up the output of the command (error: " << err << ")!" << endl;
+			return false;
+		}
+		PhaseMarkers markers;
+		if (options.markers) {
+			if (auto err = markers.open(); err) {
+				if (w32_error) *w32_error = err;
+				else cerr << "- Failed to create the pipe for the phase markers (error: " << err << ")!" << endl;
+				return false;
+			}
+		}
+		string environment; // (Empty: inherit ours)
+		if (options.markers || options.env_size) {
+			// Our environment block, plus the marker pipe and/or the padding:
+			if (auto env = GetEnvironmentStringsA()) {
+				auto name_len = strlen(PhaseMarkers::MARK_ENV);
+				for (auto var = env; *var; var += strlen(var) + 1)
+					if (!options.markers || _strnicmp(var, PhaseMarkers::MARK_ENV, name_len) || var[name_len] != '=')
+						environment.append(var, strlen(var) + 1);
+				FreeEnvironmentStringsA(env);
+			}
+			if (options.markers) environment.append(markers.env()).push_back('\0');
+			if (options.env_size) {
+				if (auto pad = env_padding(environment.size(), options.env_size); !pad.empty()) {
+					environment.append(pad).push_back('\0');
+					result->controls += " env=" + to_string(environment.size());
+				}
+			}
+			environment.push_back('\0');
+		}
+		DWORD_PTR affinity = 0;
+		vector<unsigned> pinned, dropped; // (A mask only reaches the CPUs of the current processor group.)
+		for (auto c : options.cpus) {
+			if (c < 8 * sizeof(DWORD_PTR)) { affinity |= DWORD_PTR(1) << c; pinned.push_back(c); }
+			else dropped.push_back(c);
+		}
+		if (!dropped.empty())
+			cerr << "- Warning: can't pin to CPUs " << cpu_list(dropped) << " (only 0-" << 8 * sizeof(DWORD_PTR) - 1 << " here), ignored!\n";
+
+		bool redirected = output.redirected(); // (Then the handles must be inherited.)
+		if (redirected) {
+			si.dwFlags |= STARTF_USESTDHANDLES;
+			si.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+			si.hStdOutput = si.hStdError = output.child();
+		}
+		// Only these get inherited, not everything inheritable we have open: the
+		// pipes of other runs going on in parallel (--jobs, --batch) would leak
+		// into this child, and then those runs wouldn't see EOF until this exits.
+		vector<char> inherit_list;
+		if (redirected) {
+			HANDLE handles[2] = {si.hStdOutput};
+			DWORD count = 1, hflags = 0;
+			if (si.hStdInput && si.hStdInput != INVALID_HANDLE_VALUE && si.hStdInput != si.hStdOutput
+			    && GetHandleInformation(si.hStdInput, &hflags) && (hflags & HANDLE_FLAG_INHERIT))
+				handles[count++] = si.hStdInput;
+			SIZE_T size = 0;
+			InitializeProcThreadAttributeList(NULL, 1, 0, &size);
+			inherit_list.resize(size);
+			six.lpAttributeList = (LPPROC_THREAD_ATTRIBUTE_LIST)inherit_list.data();
+			if (!InitializeProcThreadAttributeList(six.lpAttributeList, 1, 0, &size)) {
+				cerr << "- Warning: failed to limit the handles inherited by the command!\n";
+				six.lpAttributeList = NULL;
+			} else if (!UpdateProcThreadAttribute(six.lpAttributeList, 0, PROC_THREAD_ATTRIBUTE_HANDLE_LIST,
+			                                      handles, count * sizeof(HANDLE), NULL, NULL)) {
+				cerr << "- Warning: failed to limit the handles inherited by the command!\n";
+				DeleteProcThreadAttributeList(six.lpAttributeList);
+				six.lpAttributeList = NULL;
+			}
+		}
+
+		// For the process tree, the limits, or killing it at a milestone: a job
+		// object, reporting its events to a completion port
+		bool limited = options.timeout > 0 || options.max_mem || options.max_cpu > 0;
+		HANDLE job = NULL, job_events = NULL;
+		if (options.tree || limited || options.kill_at_milestone) {
+			job = CreateJobObjectA(NULL, NULL);
+			job_events = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+			JOBOBJECT_ASSOCIATE_COMPLETION_PORT port = {job, job_events};
+			if (!job || !job_events || !SetInformationJobObject(job, JobObjectAssociateCompletionPortInformation, &port, sizeof(port))) {
+				cerr << "- Warning: failed to set up a job object for the process tree/limits!\n";
+				if (job) CloseHandle(job);
+				if (job_events) CloseHandle(job_events);
+				job = job_events = NULL;
+			}
+		}
+		if (job && (options.max_mem || options.max_cpu > 0)) {
+			// (Both just get reported to the port, and then the job is terminated
+			// by us, to have them all handled the same way.)
+			JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits = {};
+			if (options.max_cpu > 0) { // (User time only: the kernel time is added by polling, below.)
+				limits.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_JOB_TIME;
+				limits.BasicLimitInformation.PerJobUserTimeLimit.QuadPart = LONGLONG(options.max_cpu * 1e7); // 100 ns units
+				JOBOBJECT_END_OF_JOB_TIME_INFORMATION action = {JOB_OBJECT_POST_AT_END_OF_JOB};
+				SetInformationJobObject(job, JobObjectEndOfJobTimeInformation, &action, sizeof(action));
+			}
+			if (options.max_mem) {
+				limits.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_JOB_MEMORY;
+				limits.JobMemoryLimit = SIZE_T(options.max_mem * 1024);
+			}
+			if (!SetInformationJobObject(job, JobObjectExtendedLimitInformation, &limits, sizeof(limits)))
+				cerr << "- Warning: failed to set the limits of the job object!\n";
+		}
+
+		for (auto m : options.monitors) m->prepare();
+
+		Timer timer;
+		auto launch = timer.start();
+		output.launching(launch);
+		markers.launching(launch);
+		// (Start it suspended if it's going into the job, to not miss any subprocesses,
+		// or if it's to be pinned, to not let it run anywhere else first.)
+		bool suspended = job || affinity;
+		DWORD flags = (suspended ? CREATE_SUSPENDED : 0) | (options.high_priority ? HIGH_PRIORITY_CLASS : 0)
+		            | (six.lpAttributeList ? EXTENDED_STARTUPINFO_PRESENT : 0);
+		bool created = CreateProcessA(NULL, &cmdline_writable[0], NULL, NULL, redirected, flags,
+		                              environment.empty() ? NULL : environment.data(), NULL, &si, &pi);
+		auto lasterr = GetLastError();
+		if (six.lpAttributeList) DeleteProcThreadAttributeList(six.lpAttributeList);
+		if (!created) {
+			for (auto m : options.monitors) m->finished(*result);
+			if (job) { CloseHandle(job); CloseHandle(job_events); }
+			if (w32_error) {
+				*w32_error = lasterr;
+			} else {
+				cerr << "- CreateProcess failed (LastError: " << lasterr << ")!" << endl;
+			}
+			return false;
+		}
+
+		if (job && !AssignProcessToJobObject(job, pi.hProcess)) {
+			// (Then no events would ever come from the job, so just wait for the
+			// child, with only the timeout enforced, directly.)
+			cerr << "- Warning: failed to assign the process to the job object"
+			     << (options.tree || options.max_mem || options.max_cpu > 0 ? " (only the child is waited for, and only --timeout is enforced)" : "")
+			     << "!\n";
+			CloseHandle(job);
+			CloseHandle(job_events);
+			job = job_events = NULL;
+		}
+		output.started({pi.hProcess, pi.dwProcessId}, job);
+		if (affinity) {
+			if (SetProcessAffinityMask(pi.hProcess, affinity)) result->controls += " cpus=" + cpu_list(pinned);
+			else cerr << "- Warning: failed to pin the process to CPUs " << cpu_list(pinned) << "!\n";
+		}
+		if (suspended) ResumeThread(pi.hThread);
+		if (options.high_priority) result->controls += " priority=high";
+		// (ASLR can't be disabled per process at run time; only in the exe, or by system policy.)
+		if (!result->controls.empty()) result->controls.erase(0, 1);
+
+		for (auto m : options.monitors) m->started({pi.hProcess, pi.dwProcessId});
+
+		vector<HANDLE> members; // Processes seen in the job (for the breakdown)
+		if (job) {
+			// Wait until the last process in the job is gone (or just the child,
+			// if the job isn't for the tree), or a limit is hit:
+			auto deadline = options.timeout > 0 ? GetTickCount64() + ULONGLONG(options.timeout * 1000) : 0;
+			auto accounting = [&] {
+				JOBOBJECT_BASIC_ACCOUNTING_INFORMATION acct = {};
+				QueryInformationJobObject(job, JobObjectBasicAccountingInformation, &acct, sizeof(acct), NULL);
+				return acct;
+			};
+			auto exceeded = [&](Limit limit) {
+				// (Unless it's just done, but not yet noticed, as that was in time.)
+				if (options.tree ? !accounting().ActiveProcesses : WaitForSingleObject(pi.hProcess, 0) == WAIT_OBJECT_0) return;
+				if (!result->limit) result->limit = limit;
+				TerminateJobObject(job, 1);
+			};
+			// The CPU time limit of the job is for the user time only, so for
+			// user + kernel (as on POSIX), that's polled, too:
+			bool polling = options.max_cpu > 0;
+			static constexpr DWORD POLL_INTERVAL = 10; // ms
+			DWORD event; ULONG_PTR key; LPOVERLAPPED data;
+			for (;;) {
+				DWORD wait = INFINITE;
+				if (deadline) { auto now = GetTickCount64(); wait = now < deadline ? DWORD(deadline - now) : 0; }
+				if (polling) wait = std::min(wait, POLL_INTERVAL);
+				if (!GetQueuedCompletionStatus(job_events, &event, &key, &data, wait)) {
+					if (GetLastError() != WAIT_TIMEOUT) break;
+					if (deadline && GetTickCount64() >= deadline) {
+						exceeded(TIMEOUT);
+						deadline = 0;
+					} else if (polling) {
+						auto acct = accounting();
+						if (double(acct.TotalUserTime.QuadPart + acct.TotalKernelTime.QuadPart) / 1e7 >= options.max_cpu) {
+							exceeded(MAX_CPU);
+							polling = false;
+						}
+					}
+					continue;
+				}
+				if (key != (ULONG_PTR)job) continue;
+				if (event == JOB_OBJECT_MSG_NEW_PROCESS) {
+					// (Holding a handle keeps its data around after it exits.)
+					if (!options.tree) continue;
+					if (auto h = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION | PROCESS_VM_READ, FALSE, (DWORD)(ULONG_PTR)data))
+						members.push_back(h);
+				} else if (event == JOB_OBJECT_MSG_END_OF_JOB_TIME) {
+					exceeded(MAX_CPU);
+				} else if (event == JOB_OBJECT_MSG_JOB_MEMORY_LIMIT) {
+					exceeded(MAX_MEM);
+				} else if (event == JOB_OBJECT_MSG_ACTIVE_PROCESS_ZERO) {
+					break;
+				} else if (!options.tree && (event == JOB_OBJECT_MSG_EXIT_PROCESS || event == JOB_OBJECT_MSG_ABNORMAL_EXIT_PROCESS)
+				           && (DWORD)(ULONG_PTR)data == pi.dwProcessId) {
+					break;
+				}
+			}
+		} else {
+			auto wait = options.timeout > 0 ? DWORD(std::min(options.timeout * 1000, double(INFINITE - 1))) : INFINITE;
+			if (WaitForSingleObject(pi.hProcess, wait) == WAIT_TIMEOUT) {
+				result->limit = TIMEOUT;
+				TerminateProcess(pi.hProcess, 1);
+				WaitForSingleObject(pi.hProcess, INFINITE);
+			}
+		}
+		timer.stop();
+
+		for (auto m : options.monitors) m->finished(*result);
+
+		result->wall = timer.elapsed();
+		result->output_bytes = output.finish(result);
+		markers.finish(result);
+
+		DWORD w32_exitcode;
+		GetExitCodeProcess(pi.hProcess, &w32_exitcode);
+		result->exitcode = (int)w32_exitcode;
+		if ((result->killed = output.killed())) result->exitcode = 0; // (As it was done with.)
+
+		FILETIME created, exited, kernel, user;
+		if (GetProcessTimes(pi.hProcess, &created, &exited, &kernel, &user)) {
+			auto seconds = [](const FILETIME& ft) { // FILETIME: 100 ns units
+				return double(uint64_t(ft.dwHighDateTime) << 32 | ft.dwLowDateTime) / 1e7; };
+			result->user = seconds(user);
+			result->sys  = seconds(kernel);
+			result->cpu  = result->user + result->sys; // (Before any job totals below.)
+		}
+
+		PROCESS_MEMORY_COUNTERS pmc = {sizeof(pmc)};
+		if (GetProcessMemoryInfo(pi.hProcess, &pmc, sizeof(pmc))) {
+			result->max_rss = pmc.PeakWorkingSetSize / 1024;
+			result->minor_faults = pmc.PageFaultCount;
+		}
+
+		if (job && options.tree) {
+			JOBOBJECT_BASIC_ACCOUNTING_INFORMATION acct = {};
+			if (QueryInformationJobObject(job, JobObjectBasicAccountingInformation, &acct, sizeof(acct), NULL)) {
+				result->user = double(acct.TotalUserTime.QuadPart) / 1e7;
+				result->sys  = double(acct.TotalKernelTime.QuadPart) / 1e7;
+				result->minor_faults = acct.TotalPageFaultCount;
+				result->tree_processes = acct.TotalProcesses;
+			}
+			JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits = {};
+			if (QueryInformationJobObject(job, JobObjectExtendedLimitInformation, &limits, sizeof(limits), NULL))
+				result->max_rss = limits.PeakJobMemoryUsed / 1024; // (Committed, for the whole job, at once)
+
+			for (auto h : members) {
+				RunResult::ProcessInfo proc;
+				proc.pid = GetProcessId(h);
+				char name[MAX_PATH]; DWORD len = MAX_PATH;
+				if (QueryFullProcessImageNameA(h, 0, name, &len)) {
+					proc.name = string(name, len);
+					proc.name = proc.name.substr(proc.name.find_last_of("\\/") + 1);
+				}
+				FILETIME c, e, k, u;
+				if (GetProcessTimes(h, &c, &e, &k, &u)) {
+					auto seconds = [](const FILETIME& ft) {
+						return double(uint64_t(ft.dwHighDateTime) << 32 | ft.dwLowDateTime) / 1e7; };
+					proc.user = seconds(u);
+					proc.sys  = seconds(k);
+				}
+				PROCESS_MEMORY_COUNTERS mem = {sizeof(mem)};
+				if (GetProcessMemoryInfo(h, &mem, sizeof(mem))) proc.max_rss = mem.PeakWorkingSetSize / 1024;
+				result->processes.push_back(proc);
+				CloseHandle(h);
+			}
+		}
+		if (job) {
+			CloseHandle(job_events);
+			CloseHandle(job);
+		}
+
+		CloseHandle(pi.hProcess);
+		CloseHandle(pi.hThread);
+
+		return true;
+	}
+
+#else // POSIX
+
+#ifdef __linux__
+	//----------------------------------------------------------------------------
+	class PerfCounters // Hardware (and some software) counters of a child process
+	//----------------------------------------------------------------------------
+	// The counters are opened (disabled) on the calling thread, with `inherit`
+	// and `enable_on_exec`, so the copies inherited by a child spawned from this
+	// thread (and, in turn, by all its threads and subprocesses) start counting
+	// right at its exec, while ours never do. The children's counts are added to
+	// ours when they exit, so they can just be read after the child was reaped.
+	//----------------------------------------------------------------------------
+	{
+		int fds_[COUNTERS];
+
+	public:
+		PerfCounters()
+		{
+			static const pair<uint32_t, uint64_t> events[COUNTERS] = {
+				{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+				{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+				{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+				{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+				{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+				{PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+			};
+			static atomic<bool> warned = false; // (Parallel runs with --jobs & --batch!)
+
+			for (int c = 0; c < COUNTERS; ++c) {
+				perf_event_attr attr = {};
+				attr.size = sizeof(attr);
+				attr.type = events[c].first;
+				attr.config = events[c].second;
+				attr.disabled = 1;
+				attr.inherit = 1;
+				attr.enable_on_exec = 1;
+				attr.exclude_kernel = 1; // (Also makes it work with perf_event_paranoid = 2.)
+				attr.exclude_hv = 1;
+				attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+				fds_[c] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+				if (int err = errno; fds_[c] < 0 && !warned.exchange(true)) {
+					cerr << "- Warning: the " << CounterNames[c] << " counter is not available ("
+					     << strerror(err) << ")" << (err == EACCES || err == EPERM ?
+					        "; see /proc/sys/kernel/perf_event_paranoid" : "") << ".\n";
+				}
+			}
+		}
+
+		~PerfCounters() { for (auto fd : fds_) if (fd >= 0) close(fd); }
+
+		void read(int64_t* values) const
+		{
+			for (int c = 0; c < COUNTERS; ++c) {
+				uint64_t data[3]; // value, time enabled, time running
+				if (fds_[c] < 0 || ::read(fds_[c], data, sizeof(data)) != sizeof(data)) {
+					values[c] = -1;
+				} else { // Scale it up if it had to share the PMU with others (multiplexing):
+					values[c] = data[2] && data[2] < data[1] ? (int64_t)((double)data[0] * data[1] / data[2])
+					                                        : (int64_t)data[0];
+				}
+			}
+		}
+	};
+#endif
+
+	//----------------------------------------------------------------------------
+	class LaunchControls // Noise controls set up around posix_spawn
+	//----------------------------------------------------------------------------
+	// On Linux the affinity, the nice value and the "personality" (ASLR) are all
+	// per-thread, and inherited by the child, so they are set on the launching
+	// thread before the launch, and restored after the run, both outside of the
+	// timing. (So the child starts with them already, and it's also safe with
+	// parallel launches. Our helper threads must be started before, though, to
+	// not inherit them, too.)
+	// Elsewhere only the priority is supported, set right after the launch
+	// (plus disabling ASLR with a spawn flag on macOS).
+	//----------------------------------------------------------------------------
+	{
+		const RunOptions& options_;
+		string applied_;
+#ifdef __linux__
+		cpu_set_t saved_cpus_;
+		bool pinned_ = false;
+		int saved_nice_ = 0;
+		bool niced_ = false;
+		int saved_persona_ = -1;
+		pid_t tid_ = (pid_t)syscall(SYS_gettid);
+#endif
+		static constexpr int HIGH_PRIORITY_NICE = -10;
+
+		void applied(const string& control) { applied_ += (applied_.empty() ? "" : " ") + control; }
+
+	public:
+		LaunchControls(const RunOptions& options) : options_(options) {}
+		~LaunchControls() { restore(); }
+
+		void apply(posix_spawnattr_t* attr) // Before the launch (not timed)
+		{
+#ifdef __linux__
+			if (!options_.cpus.empty() && sched_getaffinity(0, sizeof(saved_cpus_), &saved_cpus_) == 0) {
+				cpu_set_t cpus;
+				CPU_ZERO(&cpus);
+				vector<unsigned> pinned, dropped;
+				for (auto c : options_.cpus) {
+					if (c < CPU_SETSIZE) { CPU_SET(c, &cpus); pinned.push_back(c); }
+					else dropped.push_back(c);
+				}
+				if (!dropped.empty())
+					cerr << "- Warning: can't pin to CPUs " << cpu_list(dropped) << " (only 0-" << CPU_SETSIZE - 1 << " here), ignored!\n";
+				pinned_ = !pinned.empty() && sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+				if (pinned_) applied("cpus=" + cpu_list(pinned));
+				else if (!pinned.empty()) cerr << "- Warning: failed to pin the process to CPUs " << cpu_list(pinned) << "!\n";
+			}
+			if (options_.high_priority) {
+				errno = 0;
+				saved_nice_ = getpriority(PRIO_PROCESS, (id_t)tid_);
+				niced_ = errno == 0 && setpriority(PRIO_PROCESS, (id_t)tid_, HIGH_PRIORITY_NICE) == 0;
+				if (niced_) applied("priority=high");
+			}
+			if (options_.no_aslr) {
+				saved_persona_ = personality(0xffffffff);
+				if (saved_persona_ != -1 && personality((unsigned long)saved_persona_ | ADDR_NO_RANDOMIZE) != -1) applied("aslr=off");
+				else saved_persona_ = -1;
+			}
+			(void)attr;
+#else
+#  ifdef __APPLE__
+			if (options_.no_aslr) {
+#    ifndef _POSIX_SPAWN_DISABLE_ASLR
+#      define _POSIX_SPAWN_DISABLE_ASLR 0x0100
+#    endif
+				short flags = 0;
+				posix_spawnattr_getflags(attr, &flags);
+				if (posix_spawnattr_setflags(attr, flags | _POSIX_SPAWN_DISABLE_ASLR) == 0) applied("aslr=off");
+			}
+#  else
+			(void)attr;
+#  endif
+#endif
+		}
+
+		void restore() // After the run (not timed)
+		{
+#ifdef __linux__
+			if (pinned_) sched_setaffinity(0, sizeof(saved_cpus_), &saved_cpus_);
+			if (niced_) setpriority(PRIO_PROCESS, (id_t)tid_, saved_nice_);
+			if (saved_persona_ != -1) personality((unsigned long)saved_persona_);
+			pinned_ = niced_ = false;
+			saved_persona_ = -1;
+#endif
+		}
+
+		void started(pid_t pid) // After the launch (for what couldn't be inherited)
+		{
+#ifndef __linux__
+			if (options_.high_priority && setpriority(PRIO_PROCESS, (id_t)pid, HIGH_PRIORITY_NICE) == 0) applied("priority=high");
+#else
+			(void)pid;
+#endif
+		}
+
+		void add(const string& control) { applied(control); }
+		const string& applied() const { return applied_; }
+	};
+
+	//----------------------------------------------------------------------------
+	class ProcessGroup // The child's own process group (to be killed all at once)
+	//----------------------------------------------------------------------------
+	// Out of our group, it would be a background job for the terminal: stopped
+	// (SIGTTIN) when reading from it, and not getting Ctrl-C, which would kill
+	// just us, leaving it running. So, if we're the foreground group of the
+	// terminal, that's handed over to the child's group for the run (by the
+	// spawn itself with glibc 2.35+, not to time it), and taken back after it;
+	// and if the child got killed by SIGINT or SIGQUIT, we're killed by that,
+	// too (as we would have been). Also, SIGINT, SIGTERM, SIGHUP and SIGQUIT
+	// sent to us are passed on to the group, before ending us just the same.
+	// (With parallel runs, only the first one gets the terminal.)
+	//----------------------------------------------------------------------------
+	{
+	public:
+		ProcessGroup(bool enabled) : enabled_(enabled) {}
+		~ProcessGroup() { restore_(); }
+
+		void apply(posix_spawnattr_t* attr, posix_spawn_file_actions_t* actions) // Before the launch (not timed)
+		{
+			if (!enabled_) return;
+			short flags = 0;
+			posix_spawnattr_getflags(attr, &flags);
+			posix_spawnattr_setflags(attr, flags | POSIX_SPAWN_SETPGROUP);
+			posix_spawnattr_setpgroup(attr, 0);
+
+			lock_guard lock(mutex_);
+			if (!terminal_taken_) {
+				for (int fd : {STDIN_FILENO, STDERR_FILENO, STDOUT_FILENO})
+					if (isatty(fd) && tcgetpgrp(fd) == getpgrp()) { tty_ = fd; terminal_taken_ = true; break; }
+			}
+#ifdef HAVE_SPAWN_TCSETPGRP
+			if (tty_ >= 0) handed_ = posix_spawn_file_actions_addtcsetpgrp_np(actions, tty_) == 0;
+#else
+			(void)actions;
+#endif
+			if (users_++ == 0) {
+				for (size_t i = 0; i < size(SIGNALS); ++i) {
+					struct sigaction forward = {};
+					forward.sa_handler = forward_;
+					sigemptyset(&forward.sa_mask);
+					sigaction(SIGNALS[i], nullptr, &saved_[i]);
+					if (saved_[i].sa_handler != SIG_IGN) sigaction(SIGNALS[i], &forward, nullptr); // (E.g. nohup)
+				}
+			}
+			registered_ = true;
+		}
+
+		void started(pid_t pid)
+		{
+			if (!enabled_) return;
+			for (auto& slot : pids_) {
+				pid_t free = 0;
+				if (slot.compare_exchange_strong(free, pid)) { slot_ = &slot; break; }
+			}
+			if (tty_ >= 0 && !handed_) handed_ = tcsetpgrp(tty_, pid) == 0;
+		}
+
+		bool resume(const siginfo_t& info) // If it was stopped by reading the terminal before it got it
+		{
+			if (!handed_ || info.si_code != CLD_STOPPED || (info.si_status != SIGTTIN && info.si_status != SIGTTOU)) return false;
+			siginfo_t consumed;
+			waitid(P_PID, (id_t)info.si_pid, &consumed, WSTOPPED | WNOHANG);
+			kill(-info.si_pid, SIGCONT);
+			return true;
+		}
+		bool handed() const { return handed_; }
+
+		void finished(int status) // After the run (not timed)
+		{
+			bool had_terminal = handed_;
+			restore_();
+			if (had_terminal && WIFSIGNALED(status) && (WTERMSIG(status) == SIGINT || WTERMSIG(status) == SIGQUIT)) {
+				signal(WTERMSIG(status), SIG_DFL);
+				raise(WTERMSIG(status));
+			}
+		}
+
+	private:
+		static constexpr int SIGNALS[] = {SIGINT, SIGTERM, SIGHUP, SIGQUIT};
+		static inline mutex mutex_;
+		static inline unsigned users_ = 0;
+		static inline bool terminal_taken_ = false;
+		static inline struct sigaction saved_[size(SIGNALS)];
+		static inline atomic<pid_t> pids_[64]; // Of the groups running (for the signal handler)
+
+		bool enabled_;
+		bool registered_ = false;
+		int tty_ = -1;
+		bool handed_ = false;
+		atomic<pid_t>* slot_ = nullptr;
+
+		static void forward_(int sig)
+		{
+			for (auto& slot : pids_)
+				if (pid_t pid = slot.load(); pid > 0) kill(-pid, sig);
+			signal(sig, SIG_DFL);
+			raise(sig); // (When returning from here.)
+		}
+
+		void restore_()
+		{
+			if (handed_) { // (From a background group now, so SIGTTOU would stop us.)
+				sigset_t ttou, old;
+				sigemptyset(&ttou);
+				sigaddset(&ttou, SIGTTOU);
+				pthread_sigmask(SIG_BLOCK, &ttou, &old);
+				tcsetpgrp(tty_, getpgrp());
+				pthread_sigmask(SIG_SETMASK, &old, nullptr);
+				handed_ = false;
+			}
+			if (slot_) { *slot_ = 0; slot_ = nullptr; }
+			if (!registered_) return;
+			registered_ = false;
+			lock_guard lock(mutex_);
+			if (tty_ >= 0) { terminal_taken_ = false; tty_ = -1; }
+			if (--users_ == 0)
+				for (size_t i = 0; i < size(SIGNALS); ++i)
+					if (saved_[i].sa_handler != SIG_IGN) sigaction(SIGNALS[i], &saved_[i], nullptr);
+		}
+	};
+
+	//----------------------------------------------------------------------------
+	class Watchdog // Enforces the limits of RunOptions
+	//----------------------------------------------------------------------------
+	// From a separate thread, waking up at the deadline, and also polling the
+	// CPU time and the RSS of the child (Linux only), to kill its whole process
+	// group (it's launched into a new one for this) when a limit is hit.
+	// The CPU limit is also set as an rlimit of the child (Linux), as a backstop.
+	// With --tree (on Linux), it's all the processes under us instead (as we're
+	// the subreaper then, and there's nothing else of ours running): summing
+	// their CPU time (incl. of those reaped already) and RSS, and killing them
+	// one by one, also those that left the group (e.g. with setsid), or when
+	// the child itself is gone already (so its pid isn't used then).
+	// The thread is started before the launch (see LaunchControls), and only
+	// told the pid after it.
+	//----------------------------------------------------------------------------
+	{
+	public:
+		Watchdog(const RunOptions& options) : options_(options) {}
+		~Watchdog() { stop(); }
+
+		bool active() const { return options_.timeout > 0 || options_.max_mem || options_.max_cpu > 0; }
+		Limit exceeded() const { return exceeded_; } // (After stop())
+		bool watches_tree() const // (Else it must be stopped before the child is reaped; see above.)
+		{
+#ifdef __linux__
+			return options_.tree;
+#else
+			return false;
+#endif
+		}
+
+		void prepare() // Before the launch (not timed)
+		{
+			if (active()) thread_ = thread(&Watchdog::loop_, this);
+		}
+
+		void started(pid_t pid)
+		{
+			if (!active()) return;
+#ifdef __linux__
+			if (options_.max_cpu > 0) {
+				auto seconds = (rlim_t)ceil(options_.max_cpu);
+				struct rlimit cpu_limit = {seconds, seconds + 1}; // (SIGXCPU, then SIGKILL)
+				prlimit(pid, RLIMIT_CPU, &cpu_limit, nullptr);
+			}
+			if (watches_tree()) reaped_cpu_ = children_cpu_(); // (Of the earlier runs)
+#endif
+			{ lock_guard lock(mutex_); pid_ = pid; start_ = chrono::steady_clock::now(); }
+			cv_.notify_one();
+		}
+
+		void stop() // After the child (or the whole tree) is done
+		{
+			if (!thread_.joinable()) return;
+			{ lock_guard lock(mutex_); done_ = true; }
+			cv_.notify_one();
+			thread_.join();
+		}
+
+	private:
+		static constexpr auto POLL_INTERVAL = 10ms;
+
+		const RunOptions& options_;
+		pid_t pid_ = 0;
+		chrono::steady_clock::time_point start_;
+		double reaped_cpu_ = 0;
+		Limit exceeded_ = NO_LIMIT;
+		thread thread_;
+		mutex mutex_;
+		condition_variable cv_;
+		bool done_ = false;
+
+		void loop_()
+		{
+			unique_lock lock(mutex_);
+			cv_.wait(lock, [this]{ return pid_ || done_; });
+			if (done_) return; // (Failed to launch)
+
+			using time_point = chrono::steady_clock::time_point;
+			auto deadline = options_.timeout > 0
+				? start_ + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(options_.timeout))
+				: time_point::max();
+#ifdef __linux__
+			bool polling = options_.max_mem || options_.max_cpu > 0;
+			clockid_t cpu_clock;
+			bool have_cpu_clock = options_.max_cpu > 0 && !watches_tree() && clock_getcpuclockid(pid_, &cpu_clock) == 0;
+#else
+			bool polling = false;
+#endif
+			for (;;) {
+				auto wake = polling ? std::min(deadline, chrono::steady_clock::now() + POLL_INTERVAL) : deadline;
+				if (wake == time_point::max()) { cv_.wait(lock, [this]{ return done_; }); return; }
+				if (cv_.wait_until(lock, wake, [this]{ return done_; })) return;
+
+				Limit hit = NO_LIMIT;
+				if (chrono::steady_clock::now() >= deadline) hit = TIMEOUT;
+#ifdef __linux__
+				if (!hit && polling && watches_tree()) {
+					double cpu = reaped_cpu_ >= 0 ? children_cpu_() - reaped_cpu_ : 0;
+					uint64_t rss = 0;
+					for (auto p : descendants(getpid())) {
+						if (options_.max_cpu > 0) cpu += cpu_(p);
+						if (options_.max_mem) rss += rss_(p);
+					}
+					if (options_.max_cpu > 0 && cpu >= options_.max_cpu) hit = MAX_CPU;
+					else if (options_.max_mem && rss > options_.max_mem) hit = MAX_MEM;
+				} else if (!hit && polling) {
+					timespec ts;
+					if (have_cpu_clock && clock_gettime(cpu_clock, &ts) == 0
+					    && double(ts.tv_sec) + double(ts.tv_nsec) / 1e9 >= options_.max_cpu)
+						hit = MAX_CPU;
+					else if (options_.max_mem && rss_(pid_) > options_.max_mem)
+						hit = MAX_MEM;
+				}
+#endif
+				if (hit) {
+					// (Unless it's just done, but not yet noticed, as that was in time.)
+					if (running_()) {
+						exceeded_ = hit;
+						kill_();
+					}
+					return;
+				}
+			}
+		}
+
+		bool running_() // Is there still anything to kill?
+		{
+#ifdef __linux__
+			if (watches_tree()) {
+				for (auto p : descendants(getpid())) {
+					char path[64], buf[512];
+					snprintf(path, sizeof(path), "/proc/%d/stat", (int)p);
+					int fd = open(path, O_RDONLY | O_CLOEXEC);
+					if (fd < 0) continue;
+					auto len = read(fd, buf, sizeof(buf) - 1);
+					close(fd);
+					if (len <= 0) continue;
+					buf[len] = 0;
+					auto close_paren = strrchr(buf, ')'); // "pid (name) state ..."
+					if (close_paren && close_paren[1] && close_paren[2] != 'Z') return true;
+				}
+				return false;
+			}
+#endif
+			// (Not reaped before this is stopped, so the pid is still its.)
+			siginfo_t info = {};
+			return waitid(P_PID, (id_t)pid_, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == 0;
+		}
+
+		void kill_()
+		{
+#ifdef __linux__
+			if (watches_tree()) {
+				// Until no more turn up (from forks racing with the kills):
+				vector<pid_t> killed;
+				for (bool more = true; more; ) {
+					more = false;
+					for (auto p : descendants(getpid()))
+						if (find(killed.begin(), killed.end(), p) == killed.end()) {
+							kill(p, SIGKILL);
+							killed.push_back(p);
+							more = true;
+						}
+				}
+				return;
+			}
+#endif
+			kill(-pid_, SIGKILL); // The group (even if the child is gone already)
+			kill(pid_, SIGKILL);  // (In case it failed to get its own group)
+		}
+
+#ifdef __linux__
+		static uint64_t rss_(pid_t pid) // KB
+		{
+			static const long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+			char path[64], buf[128];
+			snprintf(path, sizeof(path), "/proc/%d/statm", (int)pid);
+			int fd = open(path, O_RDONLY | O_CLOEXEC);
+			if (fd < 0) return 0;
+			auto len = read(fd, buf, sizeof(buf) - 1);
+			close(fd);
+			unsigned long long size, resident;
+			if (len <= 0 || (buf[len] = 0, sscanf(buf, "%llu %llu", &size, &resident) != 2)) return 0;
+			return resident * (unsigned long long)page_kb;
+		}
+
+		static double cpu_(pid_t pid) // Incl. its reaped children
+		{
+			static const double tick = 1.0 / (double)sysconf(_SC_CLK_TCK);
+			char path[64], buf[1024];
+			snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+			int fd = open(path, O_RDONLY | O_CLOEXEC);
+			if (fd < 0) return 0;
+			auto len = read(fd, buf, sizeof(buf) - 1);
+			close(fd);
+			if (len <= 0) return 0;
+			buf[len] = 0;
+			auto close_paren = strrchr(buf, ')'); // "pid (name) state ..."
+			unsigned long long utime, stime, cutime, cstime;
+			if (!close_paren || sscanf(close_paren + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu %llu %llu",
+			                           &utime, &stime, &cutime, &cstime) != 4) return 0;
+			return double(utime + stime + cutime + cstime) * tick;
+		}
+
+		static double children_cpu_() // Of all our reaped children
+		{
+			struct rusage ru;
+			if (getrusage(RUSAGE_CHILDREN, &ru)) return -1;
+			return double(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) + double(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+		}
+#endif
+	};
+
+	//----------------------------------------------------------------------------
+	static bool run(string_view cmdline, RunResult* result = nullptr, syserr_t* error = nullptr, const RunOptions& options = {})
+	//
+	// Same contract as the Win32 version. The command line is split back into
+	// an argv with the same (MS CRT) rules used for building it, so callers
+	// don't need to care about the platform.
+	//
+	//----------------------------------------------------------------------------
+	{
+		if (cmdline.empty()) return false;
+
+		auto args = CmdLine::split(cmdline);
+		string exe_path; // Launch it by its full path, to leave the lookup out of the timing
+		if (args.empty() || !find_executable(args[0], &exe_path)) {
+			if (error) *error = ENOENT;
+			else cerr << "- posix_spawn failed: " << strerror(ENOENT) << "!" << endl;
+			return false;
+		}
+		vector<char*> child_argv;
+		for (auto& arg : args) child_argv.push_back(arg.data());
+		child_argv.push_back(nullptr);
+		vector<char*> shell_argv; // For a script with no #! line: sh script args...
+		auto use_shell = [&] {
+			static char sh[] = "sh";
+			shell_argv = {sh, exe_path.data()};
+			shell_argv.insert(shell_argv.end(), child_argv.begin() + 1, child_argv.end());
+		};
+		if (needs_shell(exe_path)) use_shell();
+
+#ifdef __linux__
+		optional<PerfCounters> counters;
+		if (options.counters) counters.emplace();
+#else
+		(void)options;
+#endif
+
+		RunResult unused;
+		if (!result) result = &unused;
+
+#ifdef __linux__
+		if (options.tree) {
+			// Get the orphaned descendants reparented to us, instead of to init:
+			[[maybe_unused]] static bool subreaper = [] {
+				if (prctl(PR_SET_CHILD_SUBREAPER, 1) == 0) return true;
+				cerr << "- Warning: failed to become a subreaper, can't wait for the orphaned descendants!\n";
+				return false;
+			}();
+		}
+#endif
+
+		OutputRedirect output(options);
+		if (auto err = output.open(options.output_file); err) {
+			if (error) *error = err;
+			else cerr << "- Failed to set up the output of the command: " << strerror(err) << "!" << endl;
+			return false;
+		}
+		posix_spawn_file_actions_t actions;
+		posix_spawn_file_actions_init(&actions);
+		if (output.child() != OutputRedirect::NONE) {
+			posix_spawn_file_actions_adddup2(&actions, output.child(), STDOUT_FILENO);
+			posix_spawn_file_actions_adddup2(&actions, output.child(), STDERR_FILENO);
+		}
+
+		PhaseMarkers markers;
+		vector<char*> child_env = {environ, environ + [] { size_t n = 0; while (environ[n]) ++n; return n; }()};
+		string mark_env;
+		if (options.markers) {
+			if (auto err = markers.open(); err) {
+				if (error) *error = err;
+				else cerr << "- Failed to create the pipe for the phase markers: " << strerror(err) << "!" << endl;
+				return false;
+			}
+			posix_spawn_file_actions_adddup2(&actions, markers.child(), PhaseMarkers::MARK_FD);
+			mark_env = markers.env();
+			auto name_len = strlen(PhaseMarkers::MARK_ENV);
+			erase_if(child_env, [&](char* var) { return !strncmp(var, PhaseMarkers::MARK_ENV, name_len) && var[name_len] == '='; });
+			child_env.push_back(mark_env.data());
+		}
+		LaunchControls controls(options);
+		string env_pad;
+		if (options.env_size) {
+			size_t bytes = 0;
+			for (auto var : child_env) bytes += strlen(var) + 1;
+			env_pad = env_padding(bytes, options.env_size);
+			if (!env_pad.empty()) {
+				child_env.push_back(env_pad.data());
+				controls.add("env=" + to_string(bytes + env_pad.size() + 1));
+			}
+		}
+		child_env.push_back(nullptr);
+		posix_spawnattr_t attr;
+		posix_spawnattr_init(&attr);
+		Watchdog watchdog(options);
+		ProcessGroup group(watchdog.active() || options.kill_at_milestone);
+		group.apply(&attr, &actions);
+
+		for (auto m : options.monitors) m->prepare();
+		watchdog.prepare();
+		controls.apply(&attr); // (Only now, after the threads above are all up.)
+
+		pid_t pid;
+		Timer timer;
+		auto launch = timer.start();
+		output.launching(launch);
+		markers.launching(launch);
+		// posix_spawn does the vfork-style launch (no page table copying), and
+		// also reports exec failures (unlike a hand-rolled fork + exec):
+		auto spawn = [&] {
+			return shell_argv.empty() ? posix_spawn(&pid, exe_path.c_str(), &actions, &attr, child_argv.data(), child_env.data())
+			                          : posix_spawn(&pid, "/bin/sh", &actions, &attr, shell_argv.data(), child_env.data());
+		};
+		int spawn_err = spawn();
+		if (spawn_err == ENOEXEC && shell_argv.empty()) { // (Then, from now on, straight to the shell.)
+			needs_shell(exe_path, true);
+			use_shell();
+			launch = timer.start(); // (Not timing the failed attempt.)
+			output.launching(launch);
+			markers.launching(launch);
+			spawn_err = spawn();
+		}
+		posix_spawnattr_destroy(&attr);
+		posix_spawn_file_actions_destroy(&actions);
+		markers.started();
+		if (int err = spawn_err; err) {
+			for (auto m : options.monitors) m->finished(*result);
+			if (error) {
+				*error = err;
+			} else {
+				cerr << "- posix_spawn failed: " << strerror(err) << "!" << endl;
+			}
+			return false;
+		}
+
+		group.started(pid);
+		output.started({pid});
+		watchdog.started(pid);
+		controls.started(pid);
+		result->controls = controls.applied();
+		for (auto m : options.monitors) m->started({pid});
+
+		// Wait for it to end, but leave it a zombie until the monitors are done,
+		// so its pid can't be reused by something else in the meantime:
+		siginfo_t info;
+		do {
+			while (waitid(P_PID, (id_t)pid, &info, WEXITED | WNOWAIT | (group.handed() ? WSTOPPED : 0)) < 0 && errno == EINTR)
+				;
+		} while (group.resume(info));
+		if (!options.tree) timer.stop();
+		// (Before the reaping, which frees up its pid for reuse, unless it
+		// doesn't use that, as it's still needed for the rest of the tree:)
+		if (!watchdog.watches_tree()) watchdog.stop();
+
+		for (auto m : options.monitors) m->finished(*result);
+
+		// Its CPU clock can still be read while it's a zombie (unlike the rusage,
+		// that's for the process alone, and has ns resolution):
+		double cpu = -1;
+#ifdef __linux__
+		clockid_t cpu_clock;
+		timespec ts;
+		if (clock_getcpuclockid(pid, &cpu_clock) == 0 && clock_gettime(cpu_clock, &ts) == 0)
+			cpu = double(ts.tv_sec) + double(ts.tv_nsec) / 1e9;
+#endif
+
+		// Reap a process, adding its resource usage (incl. that of its own, already
+		// reaped children) to the results:
+		auto reap = [&](pid_t p, int* status) {
+			RunResult::ProcessInfo proc;
+			proc.pid = (uint64_t)p;
+			if (options.tree) proc.name = process_name(p);
+			struct rusage ru = {};
+			while (wait4(p, status, 0, &ru) < 0 && errno == EINTR)
+				;
+			auto seconds = [](const timeval& tv) { return double(tv.tv_sec) + double(tv.tv_usec) / 1e6; };
+			proc.user    = seconds(ru.ru_utime);
+			proc.sys     = seconds(ru.ru_stime);
+			proc.max_rss = (uint64_t)ru.ru_maxrss; // Already KB on Linux (but bytes on macOS!)
+#ifdef __APPLE__
+			proc.max_rss /= 1024;
+#endif
+			result->user += proc.user;
+			result->sys  += proc.sys;
+			result->max_rss = std::max(result->max_rss, proc.max_rss); // (Of any single process...)
+			result->major_faults += (uint64_t)ru.ru_majflt;
+			result->minor_faults += (uint64_t)ru.ru_minflt;
+			result->vol_ctxsw    += (uint64_t)ru.ru_nvcsw;
+			result->invol_ctxsw  += (uint64_t)ru.ru_nivcsw;
+			return proc;
+		};
+
+		int status = 0;
+		auto child = reap(pid, &status);
+		result->cpu = cpu >= 0 ? cpu : child.user + child.sys;
+		if (options.tree) {
+			result->processes.push_back(child);
+#ifdef __linux__
+			// The rest of the tree: as the "subreaper", we get all the orphaned
+			// descendants reparented to us, so just wait until there are no more:
+			for (;;) {
+				if (waitid(P_ALL, 0, &info, WEXITED | WNOWAIT) < 0) {
+					if (errno == EINTR) continue;
+					break; // ECHILD
+				}
+				int orphan_status;
+				result->processes.push_back(reap(info.si_pid, &orphan_status));
+			}
+#endif
+			result->tree_processes = (unsigned)result->processes.size();
+			timer.stop();
+		}
+		controls.restore();
+		group.finished(status);
+		watchdog.stop();
+		result->limit = watchdog.exceeded();
+		if (!result->limit && options.max_cpu > 0 && WIFSIGNALED(status) // (By the rlimit)
+		    && (WTERMSIG(status) == SIGXCPU || (WTERMSIG(status) == SIGKILL && result->cpu >= options.max_cpu)))
+			result->limit = MAX_CPU;
+
+		result->wall = timer.elapsed();
+		result->output_bytes = output.finish(result);
+		markers.finish(result);
+		// Report signals the same way as the shells do:
+		result->exitcode = WIFEXITED(status) ? WEXITSTATUS(status)
+		                 : WIFSIGNALED(status) ? 128 + WTERMSIG(status) : -1;
+		if ((result->killed = output.killed() && WIFSIGNALED(status))) result->exitcode = 0; // (As it was done with.)
+#ifdef __linux__
+		if (counters) counters->read(result->counters);
+#endif
+
+		return true;
+	}
+#endif
+} // namespace sys
+
+//----------------------------------------------------------------------------
+class Exporter // Machine-readable results: one record per (measured) run
+//----------------------------------------------------------------------------
+// JSON (an array), CSV (with a header) and NDJSON (one object per line,
+// appended, and flushed immediately, so it can be tailed while running).
+//----------------------------------------------------------------------------
+{
+	struct Field { const char* name; string value; bool is_text = false; };
+
+	ofstream json_, csv_, ndjson_;
+	bool json_empty_ = true;
+
+	static string json_string(string_view s)
+	{
+		string out = "\"";
+		for (unsigned char c : s) {
+			switch (c) {
+			case '"':  out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if (c < 0x20) { char buf[8]; snprintf(buf, sizeof(buf), "\\u%04x", c); out += buf; }
+				else out += (char)c;
+			}
+		}
+		return out + '"';
+	}
+
+	static string csv_string(string_view s)
+	{
+		if (s.find_first_of(",\"\r\n") == string_view::npos) return string(s);
+		string out = "\"";
+		for (char c : s) { if (c == '"') out += '"'; out += c; }
+		return out + '"';
+	}
+
+	static string timestamp() // ISO 8601, UTC
+	{
+		auto now = chrono::system_clock::now();
+		auto t = chrono::system_clock::to_time_t(now);
+		auto ms = chrono::duration_cast<chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+		tm utc;
+#ifdef _WIN32
+		gmtime_s(&utc, &t);
+#else
+		gmtime_r(&t, &utc);
+#endif
+		char buf[32], msbuf[8];
+		strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &utc);
+		snprintf(msbuf, sizeof(msbuf), ".%03dZ", (int)ms);
+		return string(buf) + msbuf;
+	}
+
+	static vector<Field> fields(string_view cmdline, unsigned run, const sys::RunResult& r)
+	{
+		static const string host = sys::hostname();
+		auto num = [](auto x) { ostringstream o; o << setprecision(9) << x; return o.str(); };
+		auto counter = [&](sys::Counter c) { return r.counters[c] < 0 ? "" : num(r.counters[c]); }; // "": null
+		string marks; // "name=seconds;..."
+		for (const auto& [name, t] : r.marks) marks += (marks.empty() ? "" : ";") + name + "=" + num(t);
+		return {
+			{"timestamp",    timestamp(), true},
+			{"host",         host, true},
+			{"os",           sys::OSTag, true},
+			{"arch",         sys::BitArchTag(), true},
+			{"wtime",        VERSION, true},
+			{"command",      string(cmdline), true},
+			{"run",          num(run)},
+			{"exitcode",     num(r.exitcode)},
+			{"wall_s",       num(r.wall)},
+			{"user_s",       num(r.user)},
+			{"sys_s",        num(r.sys)},
+			{"cpu_s",        num(r.cpu)},
+			{"output_bytes", r.output_bytes < 0 ? "" : num(r.output_bytes)},
+			{"first_output_s", r.first_output < 0 ? "" : num(r.first_output)},
+			{"first_match_s", r.first_match < 0 ? "" : num(r.first_match)},
+			{"max_rss_kb",   num(r.max_rss)},
+			{"max_rss_of",   r.max_rss_of(), true},
+			{"major_faults", num(r.major_faults)},
+			{"minor_faults", num(r.minor_faults)},
+			{"vol_ctxsw",    num(r.vol_ctxsw)},
+			{"invol_ctxsw",  num(r.invol_ctxsw)},
+			{"cycles",        counter(sys::CYCLES)},
+			{"instructions",  counter(sys::INSTRUCTIONS)},
+			{"cache_refs",    counter(sys::CACHE_REFS)},
+			{"cache_misses",  counter(sys::CACHE_MISSES)},
+			{"branch_misses", counter(sys::BRANCH_MISSES)},
+			{"task_clock_ns", counter(sys::TASK_CLOCK)},
+			{"mem_samples",   num(r.mem_samples)},
+			{"mem_peak_kb",   r.mem_samples ? num(r.mem_peak) : ""},
+			{"mem_peak_time_s", r.mem_samples ? num(r.mem_peak_time) : ""},
+			{"mem_avg_kb",    r.mem_samples ? num(r.mem_avg) : ""},
+			{"pss_peak_kb",   r.mem_samples ? num(r.pss_peak) : ""},
+			{"swap_peak_kb",  r.mem_samples ? num(r.swap_peak) : ""},
+			{"threads",       r.thread_samples ? num(r.threads.size()) : ""},
+			{"parallelism_avg", r.thread_samples && r.wall > 0 ? num(r.cpu / r.wall) : ""},
+			{"parallelism_peak", r.thread_samples ? num(r.parallelism_peak) : ""},
+			{"tree_processes", num(r.tree_processes)},
+			{"marks",        marks, true},
+			{"controls",     r.controls, true},
+			{"limit",        sys::LimitNames[r.limit], true},
+		};
+	}
+
+	static string json_object(const vector<Field>& fields)
+	{
+		string out = "{";
+		for (const auto& f : fields) {
+			if (out.size() > 1) out += ", ";
+			out += json_string(f.name) + ": " + (f.is_text ? json_string(f.value) : f.value.empty() ? "null" : f.value);
+		}
+		return out + "}";
+	}
+
+public:
+	bool open_json(const string& path)   { json_.open(path); if (json_) json_ << "["; return !!json_; }
+	bool open_ndjson(const string& path) { ndjson_.open(path, ios::app); return !!ndjson_; }
+	bool open_csv(const string& path)
+	{
+		csv_.open(path);
+		if (!csv_) return false;
+		string header;
+		for (const auto& f : fields("", 0, {})) header += (header.empty() ? "" : ",") + string(f.name);
+		csv_ << header << '\n';
+		return true;
+	}
+
+	~Exporter() { if (json_.is_open()) json_ << (json_empty_ ? "]\n" : "\n]\n"); }
+
+	void record(string_view cmdline, unsigned run, const sys::RunResult& result)
+	{
+		if (!json_.is_open() && !csv_.is_open() && !ndjson_.is_open()) return;
+
+		auto f = fields(cmdline, run, result);
+		if (json_.is_open()) {
+			json_ << (json_empty_ ? "\n  " : ",\n  ") << json_object(f);
+			json_empty_ = false;
+		}
+		if (ndjson_.is_open()) {
+			ndjson_ << json_object(f) << endl; // (flush!)
+		}
+		if (csv_.is_open()) {
+			string row;
+			for (const auto& field : f) row += (row.empty() ? "" : ",") + (field.is_text ? csv_string(field.value) : field.value);
+			csv_ << row << '\n';
+		}
+	}
+};
+
+//----------------------------------------------------------------------------
+struct Baseline // Saved sample distribution to check later runs against
+//----------------------------------------------------------------------------
+// File format (text, one item per line):
+//	wtime-baseline 1
+//	<command line>
+//	<elapsed times of each run, in seconds, separated by spaces>
+//----------------------------------------------------------------------------
+{
+	string command;
+	vector<double> samples;
+
+	static string path(const string& name) // $WTIME_BASELINE_DIR/name.baseline
+	{
+		const char* dir = getenv("WTIME_BASELINE_DIR");
+		return (dir && *dir ? string(dir) + "/" : "") + name + ".baseline";
+	}
+
+	bool save(const string& name) const
+	{
+		ofstream out(path(name));
+		out << "wtime-baseline 1\n" << command << '\n' << setprecision(9);
+		for (size_t i = 0; i < samples.size(); ++i) out << (i ? " " : "") << samples[i];
+		out << '\n';
+		return !!out;
+	}
+
+	bool load(const string& name)
+	{
+		ifstream in(path(name));
+		string magic;
+		if (!getline(in, magic) || magic != "wtime-baseline 1" || !getline(in, command)) return false;
+		samples.clear();
+		for (double x; in >> x; ) samples.push_back(x);
+		return !samples.empty();
+	}
+};
+
+
+//============================================================================
+// Main...
+//============================================================================
+
+auto bailout_start = chrono::steady_clock::now(); // (Not a Timer, as --clock may switch its source later.)
+auto& normal_out = cfg.Results_To_Stdout ? cout : cerr;
+Exporter exporter;
+Stats launch_overhead; // n == 0: not calibrated
+sys::RunOptions run_options; // For the measured runs (but not e.g. the calibration)
+unique_ptr<sys::MemSampler> mem_sampler; // --mem-sample
+unique_ptr<sys::ThreadSampler> thread_sampler; // --thread-sample
+ofstream mem_timeline;                   // --mem-timeline
+
+//----------------------------------------------------------------------------
+void save_mem_timeline(unsigned run)
+// Append the memory samples of the last run (as TSV, for plotting)
+//----------------------------------------------------------------------------
+{
+	if (!mem_sampler || !mem_timeline.is_open()) return;
+	for (size_t i = 0; i < mem_sampler->size(); ++i) {
+		const auto& s = (*mem_sampler)[i];
+		mem_timeline << run << '\t' << s.t << '\t' << s.rss << '\t' << s.pss << '\t' << s.swap << '\n';
+	}
+	mem_timeline.flush();
+}
+
+//----------------------------------------------------------------------------
+double milestone(const sys::RunResult& r) // Time of the one watched for (-1: none, or not reached)
+//----------------------------------------------------------------------------
+{
+	return run_options.until_match ? r.first_match : run_options.until_output ? r.first_output : -1;
+}
+
+//----------------------------------------------------------------------------
+double measured(const sys::RunResult& r) // The elapsed (or CPU, or milestone) time to report
+//----------------------------------------------------------------------------
+{
+	auto t = cfg.CPU_Clock ? r.cpu : r.wall;
+	if (milestone(r) >= 0) t = milestone(r); // (Else the whole run, if it never came.)
+	if (!cfg.Subtract_Overhead) return t;
+	if (t < launch_overhead.mean) { // (Within the noise of the calibration, then; but no negative times.)
+		static atomic<bool> warned = false;
+		if (!warned.exchange(true))
+			cerr << "- Warning: the launch overhead is more than the measured time (of some runs), taking those as 0!\n";
+		return 0;
+	}
+	return t - launch_overhead.mean;
+}
+
+const char* measured_name()
+{
+	return run_options.until_match  ? "Time to match"
+	     : run_options.until_output ? "Time to first output"
+	     : cfg.CPU_Clock ? "CPU time" : "Elapsed time";
+}
+
+//----------------------------------------------------------------------------
+void warn_missed_milestones(const vector<sys::RunResult>& runs)
+//----------------------------------------------------------------------------
+{
+	if (!run_options.until_match && !run_options.until_output) return;
+	auto missed = count_if(runs.begin(), runs.end(), [](auto& r) { return milestone(r) < 0; });
+	if (missed)
+		cerr << "- Warning: " << (run_options.until_match ? "no match" : "no output") << " in " << missed << " of "
+		     << runs.size() << " runs (their whole run time was used instead)!\n";
+}
+
+//----------------------------------------------------------------------------
+void clock_info()
+// Resolution and read overhead of each clock source, measured (for --clock-info)
+//----------------------------------------------------------------------------
+{
+	const int READS = 1000000;
+	// Smallest step seen between consecutive reads, and the average cost of a read:
+	auto measure = [&](auto read_ns) {
+		double step = INFINITY;
+		auto first = read_ns(), prev = first;
+		for (int i = 0; i < READS; ++i) {
+			auto now = read_ns();
+			if (now > prev) step = std::min(step, now - prev);
+			prev = now;
+		}
+		return pair{step, (prev - first) / READS};
+	};
+	auto line = [](const char* name, double nominal, double step, double cost, const string& note = "") {
+		normal_out << "  " << left << setw(10) << name << right << fixed << setprecision(1)
+		           << setw(12) << nominal << setw(12) << step << setw(12) << cost
+		           << defaultfloat << setprecision(6) << (note.empty() ? "" : "  ") << note << '\n';
+	};
+
+	auto selected = Clock::selected();
+	normal_out << "Clock sources (ns; nominal resolution, smallest step seen, cost of a read):\n"
+	           << "  clock          nominal    observed   read cost\n";
+	for (int c = 0; c < Clock::SOURCES; ++c) {
+		auto source = Clock::Source(c);
+		if (!Clock::select(source)) { normal_out << "  " << left << setw(10) << Clock::Names[c] << right << "  (not available)\n"; continue; }
+		auto [step, cost] = measure([] { return double(Clock::now().time_since_epoch().count()); });
+		string note = source == selected ? "(selected)" : "";
+		if (source == Clock::TSC) {
+			ostringstream o;
+			o << setprecision(4) << Clock::tsc_ghz() << " GHz, " << (Clock::tsc_invariant() ? "invariant" : "NOT invariant!");
+			note = o.str() + (note.empty() ? "" : " " + note);
+		}
+		line(Clock::Names[c], Clock::resolution(source), step, cost, note);
+	}
+	Clock::select(selected);
+
+	// The (own) process CPU clock, as a stand-in for the child's:
+#ifdef _WIN32
+	auto [step, cost] = measure([] {
+		FILETIME c, e, k, u;
+		GetProcessTimes(GetCurrentProcess(), &c, &e, &k, &u);
+		return double((uint64_t(k.dwHighDateTime) << 32 | k.dwLowDateTime) + (uint64_t(u.dwHighDateTime) << 32 | u.dwLowDateTime)) * 100;
+	});
+	line("cpu", 100, step, cost, cfg.CPU_Clock ? "(selected)" : "");
+#else
+	timespec res = {};
+	clock_getres(CLOCK_PROCESS_CPUTIME_ID, &res);
+	auto [step, cost] = measure([] {
+		timespec ts;
+		clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+		return double(ts.tv_sec) * 1e9 + double(ts.tv_nsec);
+	});
+	line("cpu", double(res.tv_sec) * 1e9 + double(res.tv_nsec), step, cost, cfg.CPU_Clock ? "(selected)" : "");
+#endif
+}
+
+//----------------------------------------------------------------------------
+Stats calibrate(const string& self, unsigned runs)
+// Time an empty process to estimate how much of the elapsed time is actually
+// spent on launching & reaping a process.
+//----------------------------------------------------------------------------
+{
+#ifdef _WIN32
+	string cmdline = CmdLine::quote(self) + " --noop"; // Ourselves (static CRT, so about as empty as it gets)
+#else
+	string cmdline = "true"; // (Our own startup, loading libstdc++, would cost 2-3x as much.)
+	(void)self;
+#endif
+	vector<double> walls;
+	for (unsigned i = 0; i < 3 + runs; ++i) { // (3 warmup runs, to get it into the file cache)
+		sys::RunResult result; sys::syserr_t sys_error = 0;
+		if (!sys::run(cmdline, &result, &sys_error)) {
+			cerr << "- Failed to run the calibration process \"" << cmdline << "\"!\n";
+			return {};
+		}
+		if (i >= 3) walls.push_back(result.wall);
+	}
+	return Stats(walls);
+}
+
+//----------------------------------------------------------------------------
+void report_counters(const vector<sys::RunResult>& runs)
+// Performance counters (means, if more than one run)
+//----------------------------------------------------------------------------
+{
+	double mean[sys::COUNTERS] = {};
+	for (int c = 0; c < sys::COUNTERS; ++c) {
+		for (const auto& r : runs) {
+			if (r.counters[c] < 0) { mean[c] = -1; break; }
+			mean[c] += (double)r.counters[c] / runs.size();
+		}
+	}
+	auto line = [&](const char* label, int c) {
+		normal_out << label;
+		if (mean[c] < 0) normal_out << "n/a";
+		else             normal_out << fixed << setprecision(0) << mean[c] << defaultfloat << setprecision(6);
+	};
+
+	normal_out << (runs.size() > 1 ? "Counters (mean):\n" : "Counters:\n");
+	line("  cycles:        ", sys::CYCLES);
+	line("\n  instructions:  ", sys::INSTRUCTIONS);
+	if (mean[sys::CYCLES] > 0 && mean[sys::INSTRUCTIONS] >= 0)
+		normal_out << " (IPC: " << setprecision(3) << mean[sys::INSTRUCTIONS] / mean[sys::CYCLES] << setprecision(6) << ")";
+	line("\n  cache refs:    ", sys::CACHE_REFS);
+	line("\n  cache misses:  ", sys::CACHE_MISSES);
+	if (mean[sys::CACHE_REFS] > 0 && mean[sys::CACHE_MISSES] >= 0)
+		normal_out << " (" << setprecision(3) << mean[sys::CACHE_MISSES] / mean[sys::CACHE_REFS] * 100 << setprecision(6) << "%)";
+	line("\n  branch misses: ", sys::BRANCH_MISSES);
+	normal_out << "\n  task clock:    ";
+	if (mean[sys::TASK_CLOCK] < 0) normal_out << "n/a\n";
+	else normal_out << Timer::convert<CFG::Report_Time_Unit>(mean[sys::TASK_CLOCK] / 1e9) << ' ' << CFG::Report_Time_Unit::name << '\n';
+}
+
+//----------------------------------------------------------------------------
+void report_threads(const vector<sys::RunResult>& runs)
+// Results of the thread sampling (means, if more than one run; the busiest
+// threads of the last one)
+//----------------------------------------------------------------------------
+{
+	double threads = 0, avg = 0, peak = 0; unsigned n = 0;
+	for (const auto& r : runs) {
+		if (!r.thread_samples || r.wall <= 0) continue; // (Too short to sample at all)
+		++n;
+		threads += (double)r.threads.size();
+		avg += r.cpu / r.wall;
+		peak += r.parallelism_peak;
+	}
+	normal_out << "Threads (sampled at " << thread_sampler->rate() << " Hz"
+	           << (runs.size() > 1 ? ", mean of runs" : "") << "): ";
+	if (!n) { normal_out << "n/a (too short)\n"; return; }
+	threads /= n; avg /= n; peak /= n;
+	unsigned cpus = std::max(1u, thread::hardware_concurrency());
+	normal_out << setprecision(3) << threads << " seen\n"
+	           << "  parallelism: " << fixed << setprecision(2) << avg << " avg., " << peak << " peak"
+	           << defaultfloat << setprecision(6) << " (of " << cpus << " CPUs)\n";
+	if (threads > 1.5 && avg < 1.2 && cpus > 1)
+		normal_out << "  (Multithreaded, but mostly running on a single core!)\n";
+
+	const size_t TOP = 5;
+	const auto& last = runs.back().threads;
+	double total = 0;
+	for (auto& t : last) total += t.cpu;
+	normal_out << "  busiest" << (runs.size() > 1 ? " (last run)" : "") << ":\n";
+	for (size_t i = 0; i < last.size() && i < TOP; ++i) {
+		const auto& t = last[i];
+		normal_out << "  " << setw(8) << t.tid << "  " << left << setw(16) << (t.name.empty() ? "-" : t.name) << right
+		           << setw(12) << Timer::convert<CFG::Report_Time_Unit>(t.cpu) << ' ' << CFG::Report_Time_Unit::name
+		           << fixed << setprecision(1) << setw(7) << (total > 0 ? t.cpu / total * 100 : 0) << '%'
+		           << defaultfloat << setprecision(6) << '\n';
+	}
+	if (last.size() > TOP) normal_out << "  (+" << last.size() - TOP << " more)\n";
+}
+
+//----------------------------------------------------------------------------
+void report_memory(const vector<sys::RunResult>& runs)
+// Results of the memory sampling (means, if more than one run)
+//----------------------------------------------------------------------------
+{
+	double peak = 0, peak_time = 0, avg = 0, pss = 0, swap = 0; unsigned samples = 0, n = 0;
+	for (const auto& r : runs) {
+		if (!r.mem_samples) continue; // (Too short to sample at all)
+		++n;
+		samples += r.mem_samples;
+		peak += (double)r.mem_peak; peak_time += r.mem_peak_time; avg += (double)r.mem_avg;
+		pss += (double)r.pss_peak; swap += (double)r.swap_peak;
+	}
+	normal_out << "Memory (sampled at " << mem_sampler->rate() << " Hz, " << samples << " samples"
+	           << (runs.size() > 1 ? ", mean of runs" : "") << "):\n";
+	if (!n) { normal_out << "  n/a (too short)\n"; return; }
+	normal_out << fixed << setprecision(0)
+		<< "  peak RSS:  " << peak / n << " KB, at "
+		<< defaultfloat << setprecision(6) << Timer::convert<CFG::Report_Time_Unit>(peak_time / n) << ' ' << CFG::Report_Time_Unit::name << '\n'
+		<< fixed << setprecision(0)
+		<< "  avg. RSS:  " << avg / n << " KB\n"
+#ifndef _WIN32
+		<< "  peak PSS:  " << pss / n << " KB\n"
+		<< "  peak swap: " << swap / n << " KB\n"
+#endif
+		<< defaultfloat << setprecision(6);
+}
+
+//----------------------------------------------------------------------------
+void report_tree(const vector<sys::RunResult>& runs)
+// Breakdown of the process tree, by process name (means, if more than one run)
+//----------------------------------------------------------------------------
+{
+	struct Entry { string name; unsigned count = 0; double cpu = 0; uint64_t max_rss = 0; };
+	vector<Entry> entries;
+	double processes = 0;
+	for (const auto& r : runs) {
+		processes += (double)r.tree_processes / runs.size();
+		for (const auto& p : r.processes) {
+			auto e = find_if(entries.begin(), entries.end(), [&](auto& e) { return e.name == p.name; });
+			if (e == entries.end()) e = entries.insert(entries.end(), {p.name});
+			++e->count;
+			e->cpu += (p.user + p.sys) / runs.size();
+			e->max_rss = std::max(e->max_rss, p.max_rss);
+		}
+	}
+	sort(entries.begin(), entries.end(), [](auto& a, auto& b) { return a.cpu > b.cpu; });
+
+	const size_t TOP = 5;
+	normal_out << "Process tree" << (runs.size() > 1 ? " (mean)" : "") << ": "
+	           << setprecision(3) << processes << setprecision(6) << " processes\n";
+	for (size_t i = 0; i < entries.size() && i < TOP; ++i) {
+		const auto& e = entries[i];
+		normal_out << "  " << left << setw(16) << (e.name.empty() ? "?" : e.name) << right
+		           << " x" << setprecision(3) << double(e.count) / runs.size()
+		           << ", CPU: " << Timer::convert<CFG::Report_Time_Unit>(e.cpu) << setprecision(6) << ' ' << CFG::Report_Time_Unit::name
+		           << ", max RSS: " << e.max_rss << " KB\n";
+	}
+	if (entries.size() > TOP) normal_out << "  (+" << entries.size() - TOP << " more)\n";
+}
+
+//----------------------------------------------------------------------------
+void report_output(const vector<sys::RunResult>& runs)
+// Bytes written to stdout & stderr, and the throughput (means, if more than one run)
+//----------------------------------------------------------------------------
+{
+	double bytes = 0, wall = 0;
+	for (const auto& r : runs) {
+		if (r.output_bytes < 0) return; // (Not counted)
+		bytes += (double)r.output_bytes / runs.size();
+		wall += r.wall / runs.size();
+	}
+	normal_out << (runs.size() > 1 ? "Output (mean):      " : "Output:       ")
+	           << fixed << setprecision(0) << bytes << " bytes" << setprecision(2);
+	if (wall > 0) normal_out << ", " << bytes / wall / (1024 * 1024) << " MB/s";
+	normal_out << defaultfloat << setprecision(6) << '\n';
+}
+
+//----------------------------------------------------------------------------
+void report_phases(const vector<sys::RunResult>& runs)
+// Breakdown of the phase markers: each phase lasts until the next marker (or
+// the end of the run), with "(start)" before the first one; phases occurring
+// more than once in a run are summed. Stats are across the runs.
+//----------------------------------------------------------------------------
+{
+	auto t = [](double s) { return Timer::convert<CFG::Report_Time_Unit>(s); };
+	const auto unit = CFG::Report_Time_Unit::name;
+
+	vector<pair<string, vector<double>>> phases; // (In order of appearance)
+	auto phase = [&](const string& name) -> auto& {
+		auto p = find_if(phases.begin(), phases.end(), [&](auto& p) { return p.first == name; });
+		return p != phases.end() ? p->second : phases.emplace_back(name, vector<double>{}).second;
+	};
+	for (size_t i = 0; i < runs.size(); ++i) {
+		const auto& r = runs[i];
+		string name = "(start)";
+		double prev = 0;
+		auto add = [&](double end) {
+			auto& d = phase(name);
+			if (d.size() < i + 1) d.resize(i + 1, -1); // (-1: not in this run)
+			d[i] = std::max(d[i], 0.0) + std::max(0.0, end - prev);
+		};
+		for (const auto& [mark, when] : r.marks) { add(when); name = mark; prev = when; }
+		add(r.wall);
+	}
+
+	normal_out << "Phases (" << unit << (runs.size() > 1 ? "; mean +/- stddev, median" : "") << ", share):\n";
+	if (phases.size() == 1) { normal_out << "  (no markers received)\n"; return; }
+	vector<Stats> stats;
+	double total = 0;
+	for (auto& [name, d] : phases) {
+		erase(d, -1.0);
+		total += stats.emplace_back(d).mean * (double)d.size() / runs.size();
+	}
+	for (size_t p = 0; p < phases.size(); ++p) {
+		const auto& s = stats[p];
+		normal_out << "  " << left << setw(16) << phases[p].first << right << setw(12) << t(s.mean);
+		if (runs.size() > 1) normal_out << " +/- " << setw(10) << left << t(s.stddev) << right << "  " << setw(10) << t(s.median);
+		normal_out << fixed << setprecision(1) << setw(7) << (total > 0 ? s.mean * (double)s.n / runs.size() / total * 100 : 0) << '%'
+		           << defaultfloat << setprecision(6);
+		if (s.n < runs.size()) normal_out << " (in " << s.n << " runs)";
+		normal_out << '\n';
+	}
+}
+
+//----------------------------------------------------------------------------
+bool controls_requested()
+//----------------------------------------------------------------------------
+{
+	return !run_options.cpus.empty() || run_options.high_priority || run_options.no_aslr || run_options.env_size;
+}
+
+//----------------------------------------------------------------------------
+void report_controls(const vector<sys::RunResult>& runs)
+// The noise controls applied (the same for every run, normally), and the ones
+// requested, but not applied
+//----------------------------------------------------------------------------
+{
+	const auto& applied = runs.back().controls;
+	normal_out << "Controls: " << (applied.empty() ? "none" : applied) << '\n';
+	auto check = [&](bool requested, const char* control, const char* option, const char* hint) {
+		if (requested && applied.find(control) == string::npos)
+			cerr << "- Warning: --" << option << " was not applied (" << hint << ")!\n";
+	};
+	check(!run_options.cpus.empty(), "cpus=", "cpus", "not supported here, or invalid CPUs");
+	check(run_options.high_priority, "priority=", "high-priority", "no permission?");
+	check(run_options.no_aslr, "aslr=", "no-aslr", "not supported here");
+	check(run_options.env_size, "env=", "env-size", "the environment is already larger");
+}
+
+//----------------------------------------------------------------------------
+void report(const sys::RunResult& r)
+//----------------------------------------------------------------------------
+{
+	auto t = [](double s) { return Timer::convert<CFG::Report_Time_Unit>(s); };
+	const auto unit = CFG::Report_Time_Unit::name;
+
+	normal_out << measured_name() << ": " << (cfg.CPU_Clock && milestone(r) < 0 ? "    " : "") << t(measured(r)) << ' ' << unit;
+	if (cfg.Subtract_Overhead)
+		normal_out << " (+/- " << t(launch_overhead.stddev) << ", launch overhead of "
+		           << t(launch_overhead.mean) << " subtracted)";
+	normal_out << '\n';
+	if (cfg.CPU_Clock || milestone(r) >= 0) normal_out << "Elapsed time: " << t(r.wall) << ' ' << unit
+		<< (r.killed ? " (killed at the milestone)" : "") << '\n';
+	if (r.limit) normal_out << "LIMIT EXCEEDED: --" << sys::LimitNames[r.limit] << " (killed; the results are partial)\n";
+	normal_out
+		<< "User time:    " << t(r.user) << ' ' << unit << '\n'
+		<< "System time:  " << t(r.sys)  << ' ' << unit << '\n'
+		<< "Max RSS:      " << r.max_rss << " KB" << (r.tree_processes ? " ("s + r.max_rss_of() + ")" : "") << '\n'
+#ifdef _WIN32
+		<< "Page faults:  " << r.minor_faults << " (soft + hard)\n"
+#else
+		<< "Page faults:  " << r.major_faults << " major, " << r.minor_faults << " minor\n"
+		<< "Context switches: " << r.vol_ctxsw << " voluntary, " << r.invol_ctxsw << " involuntary\n"
+#endif
+		;
+	report_output(vector<sys::RunResult>{r});
+	warn_missed_milestones(vector<sys::RunResult>{r});
+	if (run_options.markers) report_phases(vector<sys::RunResult>{r});
+	if (controls_requested()) report_controls(vector<sys::RunResult>{r});
+	if (run_options.tree) report_tree(vector<sys::RunResult>{r});
+	if (run_options.counters) report_counters(vector<sys::RunResult>{r});
+	if (mem_sampler) report_memory(vector<sys::RunResult>{r});
+	if (thread_sampler) report_threads(vector<sys::RunResult>{r});
+}
+
+//----------------------------------------------------------------------------
+void report(const vector<sys::RunResult>& runs)
+// Statistical summary of repeated runs
+//----------------------------------------------------------------------------
+{
+	auto t = [](double s) { return Timer::convert<CFG::Report_Time_Unit>(s); };
+	const auto unit = CFG::Report_Time_Unit::name;
+
+	vector<double> walls;
+	double user = 0, sys = 0; uint64_t max_rss = 0; unsigned failed = 0, limited = 0;
+	for (const auto& r : runs) {
+		walls.push_back(measured(r));
+		user += r.user; sys += r.sys;
+		max_rss = std::max(max_rss, r.max_rss);
+		if (r.limit) ++limited;
+		else if (r.exitcode) ++failed;
+	}
+	Stats s(walls);
+
+	normal_out << "Runs: " << s.n;
+	if (cfg.Warmup) normal_out << " (+" << cfg.Warmup << " warmup)";
+	normal_out << '\n'
+		<< measured_name() << " (" << unit << "):\n"
+		<< "  mean:    " << t(s.mean) << " +/- " << t(s.stddev) << " (stddev)\n";
+	if (cfg.Subtract_Overhead) {
+		// The uncertainty of the mean now also includes that of the overhead estimate:
+		auto stderr_mean = sqrt(s.stddev * s.stddev / s.n
+		                      + launch_overhead.stddev * launch_overhead.stddev / launch_overhead.n);
+		normal_out
+		<< "           (launch overhead of " << t(launch_overhead.mean) << " subtracted;"
+		<< " std. error of the mean: " << t(stderr_mean) << ")\n";
+	}
+	normal_out
+		<< "  median:  " << t(s.median) << '\n'
+		<< "  min/max: " << t(s.min) << " / " << t(s.max) << '\n'
+		<< "  p90/p99: " << t(s.p90) << " / " << t(s.p99) << '\n'
+		<< "  outliers: ";
+	if (s.outliers.empty()) normal_out << "none";
+	else {
+		normal_out << s.outliers.size() << " (";
+		for (auto i : s.outliers)
+			normal_out << (i == s.outliers.front() ? "" : ", ") << "#" << i + 1 << ": " << t(walls[i]);
+		normal_out << ")";
+	}
+	normal_out << '\n'
+		<< s.histogram(walls, t)
+		<< "User time (mean):   " << t(user / s.n) << ' ' << unit << '\n'
+		<< "System time (mean): " << t(sys / s.n)  << ' ' << unit << '\n'
+		<< "Max RSS (max):      " << max_rss << " KB"
+		<< (runs.front().tree_processes ? " ("s + runs.front().max_rss_of() + ")" : "") << '\n';
+	report_output(runs);
+	warn_missed_milestones(runs);
+	if (run_options.markers) report_phases(runs);
+	if (controls_requested()) report_controls(runs);
+	if (run_options.tree) report_tree(runs);
+	if (run_options.counters) report_counters(runs);
+	if (mem_sampler) report_memory(runs);
+	if (thread_sampler) report_threads(runs);
+
+	if (failed)
+		cerr << "- Warning: " << failed << " of " << s.n << " runs exited with non-zero code!\n";
+	if (limited)
+		cerr << "- Warning: " << limited << " of " << s.n << " runs were killed at a limit (their results are partial)!\n";
+}
+
+//----------------------------------------------------------------------------
+void report_error(const string& exename, sys::syserr_t sys_error)
+//----------------------------------------------------------------------------
+{
+	cerr << "- Failed to run \""<< exename <<"\": ";
+#ifdef _WIN32
+	switch (sys_error) {
+		case ERROR_FILE_NOT_FOUND: cerr << "file not found"; break;
+		case ERROR_PATH_NOT_FOUND: cerr << "path not found"; break;
+		case ERROR_ACCESS_DENIED: cerr << "access denied"; break;
+		case ERROR_INVALID_EXE_SIGNATURE:
+		case ERROR_EXE_MARKED_INVALID:
+		case ERROR_BAD_EXE_FORMAT:
+		case ERROR_EXE_MACHINE_TYPE_MISMATCH:
+		case ERROR_BAD_FORMAT: cerr << "invalid file type/format"; break;
+		case ERROR_NOT_ENOUGH_MEMORY:
+		case ERROR_OUTOFMEMORY: cerr << "not enough memory"; break;
+		default: cerr << "unknown error: " << sys_error << ")";
+	}
+#else
+	switch (sys_error) {
+		case ENOENT: cerr << "file not found"; break;
+		case EACCES: cerr << "access denied"; break;
+		case ENOEXEC: cerr << "invalid file type/format"; break;
+		case ENOMEM: cerr << "not enough memory"; break;
+		default: cerr << strerror(sys_error);
+	}
+#endif
+	cerr << "!\n";
+}
+
+//----------------------------------------------------------------------------
+int check_baseline(const string& cmdline, const vector<double>& walls)
+// Returns EXIT_REGRESSION if the new samples are significantly slower than
+// the saved baseline: i.e. the 95% CI of the difference of the means is above
+// zero, and the mean slowdown also exceeds the threshold; EXIT_USAGE if the
+// baseline couldn't be loaded (not passing the gate silently), or else 0.
+//----------------------------------------------------------------------------
+{
+	Baseline baseline;
+	if (!baseline.load(cfg.Check_Baseline)) { // (Checked already, but it may have just been removed...)
+		cerr << "- Failed to load the baseline from \"" << Baseline::path(cfg.Check_Baseline) << "\"!\n";
+		return EXIT_USAGE;
+	}
+	if (baseline.command != cmdline)
+		cerr << "- Warning: the baseline was measured with a different command: " << baseline.command << '\n';
+
+	Stats before(baseline.samples), now(walls);
+	Welch w(before, now);
+	auto pct = [&](double d) { ostringstream o; o << showpos << fixed << setprecision(1)
+	                                              << d / before.mean * 100 << '%'; return o.str(); };
+	bool regression = w.lo > 0 && w.diff / before.mean * 100 > cfg.Threshold;
+
+	normal_out
+		<< "Baseline \"" << cfg.Check_Baseline << "\": " << before.n << " runs, mean "
+		<< Timer::convert<CFG::Report_Time_Unit>(before.mean) << ' ' << CFG::Report_Time_Unit::name << '\n'
+		<< "  change: " << pct(w.diff) << " (95% CI: " << pct(w.lo) << " .. " << pct(w.hi) << ")\n"
+		<< "  verdict: " << (regression ? "REGRESSION" : w.hi < 0 ? "faster" : w.significant() ? "slower, within threshold" : "no significant difference")
+		<< " (threshold: " << cfg.Threshold << "%)\n";
+
+	return regression ? EXIT_REGRESSION : 0;
+}
+
+//----------------------------------------------------------------------------
+int benchmark(const string& exename, const string& cmdline)
+// Do the warmup and measured runs, all using the same command line.
+// Returns the exit code for wtime.
+//----------------------------------------------------------------------------
+{
+	vector<sys::RunResult> samples;
+	for (unsigned i = 0; i < cfg.Warmup + cfg.Runs; ++i) {
+		sys::RunResult result; sys::syserr_t sys_error = 0;
+		if (!sys::run(cmdline, &result, &sys_error, run_options)) {
+			report_error(exename, sys_error);
+			return EXIT_RUN_FAILED;
+		}
+		if (cfg.Verbose) normal_out << (i < cfg.Warmup ? "- warmup " : "- run ") << i + 1 << ": "
+			<< Timer::convert<CFG::Report_Time_Unit>(result.wall) << ' ' << CFG::Report_Time_Unit::name << '\n';
+		if (i >= cfg.Warmup || result.limit) {
+			samples.push_back(result);
+			exporter.record(cmdline, (unsigned)samples.size(), result);
+			save_mem_timeline((unsigned)samples.size());
+		}
+		if (result.limit) { // (It's not going to do any better next time.)
+			cerr << "- " << (i < cfg.Warmup ? "Warmup run " : "Run ") << i + 1 << " exceeded --"
+			     << sys::LimitNames[result.limit] << ", stopping.\n";
+			break;
+		}
+	}
+
+	if (samples.size() == 1) report(samples.front());
+	else                     report(samples);
+
+	if (samples.back().limit) return EXIT_LIMIT; // (No baselines from partial results.)
+	int exitcode = samples.back().exitcode;
+
+	vector<double> walls;
+	for (const auto& r : samples) walls.push_back(measured(r));
+	if (!cfg.Save_Baseline.empty()) {
+		if (Baseline{cmdline, walls}.save(cfg.Save_Baseline)) {
+			if (cfg.Verbose) normal_out << "Baseline saved to: " << Baseline::path(cfg.Save_Baseline) << '\n';
+		} else {
+			cerr << "- Failed to save the baseline to \"" << Baseline::path(cfg.Save_Baseline) << "\"!\n";
+		}
+	}
+	if (!cfg.Check_Baseline.empty()) {
+		// (Over the command's own exit code, as a gate shouldn't pass, or fail
+		// for some other reason, just because the command happened to fail.)
+		if (auto verdict = check_baseline(cmdline, walls)) exitcode = verdict;
+	}
+
+	return exitcode;
+}
+
+//----------------------------------------------------------------------------
+int scale(const string& exename, const string& cmdline, vector<unsigned> levels, bool pin)
+// Run N instances of the command at once, for each N of the levels, to see
+// where it stops scaling: the makespan (until the last one is done), the
+// latency of the instances, and the throughput, relative to a single one.
+//----------------------------------------------------------------------------
+{
+	if (find(levels.begin(), levels.end(), 1u) == levels.end())
+		levels.insert(levels.begin(), 1); // The reference for the efficiency
+
+	auto t = [](double s) { return Timer::convert<CFG::Report_Time_Unit>(s); };
+	const auto unit = CFG::Report_Time_Unit::name;
+	unsigned cpus = std::max(1u, thread::hardware_concurrency());
+
+	struct Level { unsigned jobs; Stats makespan, latency; double throughput; };
+	vector<Level> results;
+	int exitcode = 0;
+	unsigned exported = 0, limited = 0;
+	for (auto n : levels) {
+		vector<double> makespans, latencies;
+		for (unsigned i = 0; i < cfg.Warmup + cfg.Runs; ++i) {
+			vector<sys::RunResult> runs(n);
+			vector<sys::syserr_t> errors(n, 0);
+			vector<char> launched(n, false);
+			vector<thread> threads;
+			latch ready((ptrdiff_t)n + 1);
+			for (unsigned j = 0; j < n; ++j) {
+				threads.emplace_back([&, j] {
+					auto options = run_options;
+					if (pin) options.cpus = {run_options.cpus.empty() ? j % cpus : run_options.cpus[j % run_options.cpus.size()]};
+					ready.arrive_and_wait(); // Start them all at once
+					launched[j] = sys::run(cmdline, &runs[j], &errors[j], options);
+				});
+			}
+			Timer makespan;
+			ready.arrive_and_wait();
+			makespan.start();
+			for (auto& th : threads) th.join();
+			makespan.stop();
+
+			for (unsigned j = 0; j < n; ++j) {
+				if (!launched[j]) { report_error(exename, errors[j]); return EXIT_RUN_FAILED; }
+				if (runs[j].limit) ++limited;
+				else if (runs[j].exitcode) exitcode = runs[j].exitcode;
+			}
+			if (cfg.Verbose) normal_out << "- " << n << " jobs, " << (i < cfg.Warmup ? "warmup " : "run ") << i + 1 << ": "
+				<< t(makespan.elapsed()) << ' ' << unit << '\n';
+			if (i < cfg.Warmup) continue;
+			makespans.push_back(makespan.elapsed());
+			for (const auto& r : runs) {
+				latencies.push_back(measured(r));
+				exporter.record(cmdline, ++exported, r);
+			}
+		}
+		Stats m(makespans);
+		results.push_back({n, m, Stats(latencies), m.mean > 0 ? n / m.mean : 0});
+	}
+
+	const auto& single = *find_if(results.begin(), results.end(), [](auto& l) { return l.jobs == 1; });
+	// (In ms, with fixed decimals, so the columns stay apart even for very short commands.)
+	auto ms = [](double s) { return Timer::convert<TimeUnit::ms>(s); };
+	normal_out << "Concurrency scaling (ms, " << cfg.Runs << (cfg.Runs > 1 ? " runs" : " run") << " of each level"
+	           << (pin ? ", pinned" : "") << "):\n"
+	           << setw(7) << "jobs" << setw(13) << "makespan" << setw(13) << "lat. mean" << setw(12) << "lat. p90"
+	           << setw(12) << "lat. max" << setw(14) << "throughput" << setw(11) << "efficiency" << '\n';
+	for (const auto& l : results) {
+		auto efficiency = single.throughput > 0 ? l.throughput / (l.jobs * single.throughput) * 100 : 0;
+		normal_out << fixed << setprecision(3)
+			<< setw(7) << l.jobs
+			<< setw(13) << ms(l.makespan.mean)
+			<< setw(13) << ms(l.latency.mean)
+			<< setw(12) << ms(l.latency.p90)
+			<< setw(12) << ms(l.latency.max)
+			<< setprecision(1)
+			<< setw(12) << l.throughput << "/s"
+			<< setw(10) << efficiency << '%'
+			<< defaultfloat << setprecision(6) << '\n';
+	}
+
+	if (exitcode)
+		cerr << "- Warning: some runs exited with non-zero code!\n";
+	if (limited) {
+		cerr << "- Warning: " << limited << " instances were killed at a limit (their results are partial)!\n";
+		return EXIT_LIMIT;
+	}
+	return exitcode;
+}
+
+//----------------------------------------------------------------------------
+int batch(const string& manifest, unsigned parallel, unsigned slowest)
+// Time each command of a manifest file (one per line, quoted like on our own
+// command line; blank lines and #comments are ignored) independently, on a
+// pool of `parallel` workers, then report the slowest ones.
+//----------------------------------------------------------------------------
+{
+	struct Command {
+		unsigned line;
+		string cmdline;
+		vector<sys::RunResult> runs;
+		double wall = 0; // Mean of the runs
+		bool launched = false;
+		sys::syserr_t error = 0;
+	};
+	vector<Command> commands;
+	{
+		ifstream file(manifest);
+		if (!file) { cerr << "- Failed to open the batch file \"" << manifest << "\"!\n"; return EXIT_USAGE; }
+		string line;
+		for (unsigned n = 1; getline(file, line); ++n) {
+			if (!line.empty() && line.back() == '\r') line.pop_back();
+			auto words = CmdLine::split(line);
+			if (words.empty() || words[0][0] == '#') continue;
+			commands.push_back({n, CmdLine::build(words), {}});
+		}
+	}
+	if (commands.empty()) { cerr << "- No commands in the batch file \"" << manifest << "\"!\n"; return EXIT_USAGE; }
+
+	auto t = [](double s) { return Timer::convert<CFG::Report_Time_Unit>(s); };
+	const auto unit = CFG::Report_Time_Unit::name;
+
+	WorkPool pool(parallel);
+	mutex output;
+	Timer makespan(Timer::Start);
+	pool.run(commands.size(), [&](size_t c, unsigned) {
+		auto& cmd = commands[c];
+		for (unsigned i = 0; i < cfg.Warmup + cfg.Runs; ++i) {
+			sys::RunResult result;
+			if (!(cmd.launched = sys::run(cmd.cmdline, &result, &cmd.error, run_options))) return;
+			if (i >= cfg.Warmup || result.limit) cmd.runs.push_back(result);
+			if (result.limit) break; // (Partial results, but still in the ranking.)
+		}
+		for (const auto& r : cmd.runs) cmd.wall += measured(r) / cmd.runs.size();
+
+		lock_guard guard(output);
+		for (unsigned i = 0; i < cmd.runs.size(); ++i)
+			exporter.record(cmd.cmdline, i + 1, cmd.runs[i]);
+		if (cfg.Verbose) normal_out << "- [line " << cmd.line << "] " << t(cmd.wall) << ' ' << unit
+		                            << ": " << cmd.cmdline << '\n';
+	});
+	makespan.stop();
+
+	double total = 0;
+	unsigned not_launched = 0, failed = 0, limited = 0;
+	int exitcode = 0;
+	vector<const Command*> ranking;
+	for (const auto& cmd : commands) {
+		if (!cmd.launched) {
+			++not_launched;
+			cerr << "[line " << cmd.line << "] ";
+			report_error(CmdLine::split(cmd.cmdline)[0], cmd.error);
+			continue;
+		}
+		total += cmd.wall * cmd.runs.size();
+		ranking.push_back(&cmd);
+		if (cmd.runs.back().limit) {
+			++limited;
+		} else if (auto code = cmd.runs.back().exitcode; code) {
+			++failed;
+			if (!exitcode) exitcode = code;
+		}
+	}
+	sort(ranking.begin(), ranking.end(), [](auto a, auto b) { return a->wall > b->wall; });
+
+	normal_out << "Batch: " << commands.size() << " commands";
+	if (cfg.Runs > 1) normal_out << " x " << cfg.Runs << " runs";
+	normal_out << ", " << pool.size() << " workers\n"
+		<< "  makespan:     " << t(makespan.elapsed()) << ' ' << unit << '\n'
+		<< "  sum of times: " << t(total) << ' ' << unit
+		<< " (" << setprecision(3) << total / makespan.elapsed() << setprecision(6) << "x parallel)\n";
+	if (failed)       normal_out << "  failed:       " << failed << " (non-zero exit code)\n";
+	if (limited)      normal_out << "  killed:       " << limited << " (at a limit)\n";
+	if (not_launched) normal_out << "  not run:      " << not_launched << '\n';
+	normal_out << "Slowest " << std::min((size_t)slowest, ranking.size()) << (cfg.Runs > 1 ? " (mean):\n" : ":\n");
+	for (size_t i = 0; i < ranking.size() && i < slowest; ++i) {
+		const auto& cmd = *ranking[i];
+		normal_out << setw(12) << t(cmd.wall) << ' ' << unit
+		           << setprecision(3) << setw(7) << (total ? cmd.wall * cmd.runs.size() / total * 100 : 0) << setprecision(6) << '%'
+		           << "  [line " << cmd.line << "] " << cmd.cmdline
+		           << (cmd.runs.back().limit ? string(" (") + sys::LimitNames[cmd.runs.back().limit] + ")"
+		              : cmd.runs.back().exitcode ? " (failed)" : "") << '\n';
+	}
+
+	return not_launched ? EXIT_RUN_FAILED : limited ? EXIT_LIMIT : exitcode;
+}
+
+//----------------------------------------------------------------------------
+int scan(const string& exename, char const* const* argv, int argc, const string& spec)
+// Time the command with each value of a parameter (`{NAME}` in its args),
+// given as NAME=START:END:STEP (STEP: +K or K to add, xK to multiply), then
+// fit the results to common complexity models.
+//----------------------------------------------------------------------------
+{
+	string name;
+	vector<uint64_t> values;
+	try {
+		auto eq = spec.find('='), c1 = spec.find(':', eq), c2 = spec.find(':', c1 + 1);
+		if (eq == 0 || eq == string::npos || c1 == string::npos || c2 == string::npos) throw 0;
+		name = spec.substr(0, eq);
+		auto number = [](const string& s) { size_t pos; auto n = stoull(s, &pos); if (pos != s.size()) throw 0; return n; };
+		auto start = number(spec.substr(eq + 1, c1 - eq - 1)), end = number(spec.substr(c1 + 1, c2 - c1 - 1));
+		auto step = spec.substr(c2 + 1);
+		bool multiply = !step.empty() && (step[0] == 'x' || step[0] == '*');
+		if (!step.empty() && (multiply || step[0] == '+')) step.erase(0, 1);
+		auto k = number(step);
+		if (k < (multiply ? 2u : 1u) || (multiply && !start) || start > end) throw 0; // (0 is fine for adding)
+		const size_t MAX_VALUES = 1000;
+		if (!multiply && (end - start) / k >= MAX_VALUES) {
+			cerr << "- Too many --scan values (over " << MAX_VALUES << "): \"" << spec << "\"; use a larger STEP!\n";
+			return EXIT_USAGE;
+		}
+		for (auto v = start; v <= end; v = multiply ? v * k : v + k) {
+			values.push_back(v);
+			if (multiply ? v > UINT64_MAX / k : v > UINT64_MAX - k) break; // (Overflow!)
+		}
+	} catch (...) {
+		cerr << "- Invalid --scan: \"" << spec << "\" (expected e.g. N=1000:1000000:x10, or N=1:100:+10)\n";
+		return EXIT_USAGE;
+	}
+	const string placeholder = "{" + name + "}";
+	if (none_of(argv, argv + argc, [&](const char* a) { return string_view(a).find(placeholder) != string_view::npos; }))
+		cerr << "- Warning: " << placeholder << " is not used in the command!\n";
+
+	auto t = [](double s) { return Timer::convert<CFG::Report_Time_Unit>(s); };
+	const auto unit = CFG::Report_Time_Unit::name;
+
+	vector<double> ns, medians;
+	int exitcode = 0;
+	unsigned limited = 0;
+	for (auto value : values) {
+		vector<string> words(argv, argv + argc);
+		for (size_t w = 1; w < words.size(); ++w) // (Not in the exe name, which has been resolved already.)
+			for (size_t pos; (pos = words[w].find(placeholder)) != string::npos; )
+				words[w].replace(pos, placeholder.size(), to_string(value));
+		string cmdline = CmdLine::build(words);
+		if (cfg.Verbose) normal_out << "Executing: " << cmdline << "...\n";
+
+		vector<double> walls;
+		for (unsigned i = 0; i < cfg.Warmup + cfg.Runs; ++i) {
+			sys::RunResult result; sys::syserr_t sys_error = 0;
+			if (!sys::run(cmdline, &result, &sys_error, run_options)) {
+				report_error(exename, sys_error);
+				return EXIT_RUN_FAILED;
+			}
+			if (result.limit) ++limited;
+			else if (result.exitcode) exitcode = result.exitcode;
+			if (i < cfg.Warmup) continue;
+			walls.push_back(measured(result));
+			exporter.record(cmdline, (unsigned)walls.size(), result);
+		}
+		ns.push_back((double)value);
+		medians.push_back(Stats(walls).median);
+	}
+
+	normal_out << "Scan of " << name << " (" << unit << (cfg.Runs > 1 ? ", median of " + to_string(cfg.Runs) + " runs" : "") << "):\n";
+	for (size_t i = 0; i < ns.size(); ++i)
+		normal_out << setw(14) << (uint64_t)ns[i] << setw(14) << t(medians[i]) << '\n';
+
+	if (ns.size() < 3) {
+		normal_out << "(At least 3 values are needed for fitting a complexity model.)\n";
+	} else {
+		Complexity fit(ns, medians);
+		normal_out << "Complexity fit (t = a + c * f(" << name << "), RMS error relative to the mean):\n";
+		for (int m = 0; m < Complexity::MODELS; ++m) {
+			normal_out << "  " << left << setw(11) << Complexity::Names[m] << right;
+			if (!isfinite(fit.fits[m].rms)) normal_out << "      -";
+			else normal_out << setw(6) << fixed << setprecision(1) << fit.fits[m].rms * 100 << '%' << defaultfloat << setprecision(6);
+			if (m == fit.best) normal_out << "  <- best";
+			else if (isfinite(fit.fits[m].rms) && !fit.fits[m].significant) normal_out << "  (c not significant)";
+			normal_out << '\n';
+		}
+		const auto& best = fit.fits[fit.best];
+		if (fit.inconclusive)
+			normal_out << "Inconclusive: " << Complexity::Names[fit.best] << " and " << Complexity::Names[fit.runner_up]
+			           << " fit about equally well (within the noise); try a wider range, or more runs.\n";
+		normal_out << "Best fit: " << Complexity::Names[fit.best];
+		if (fit.best != Complexity::O_1) normal_out << ", c = " << t(best.c) << ' ' << unit << " (per f(" << name << ") unit)";
+		normal_out << ", a = " << t(best.a) << ' ' << unit << '\n';
+	}
+
+	if (exitcode)
+		cerr << "- Warning: some runs exited with non-zero code!\n";
+	if (limited) {
+		cerr << "- Warning: " << limited << " runs were killed at a limit (their results are partial)!\n";
+		return EXIT_LIMIT;
+	}
+	return exitcode;
+}
+
+//----------------------------------------------------------------------------
+int compare(int argc, char const* const* argv)
+// Run several commands (each given as one arg) interleaved round-robin, so
+// that any drift (thermal throttling, frequency scaling, background load etc.)
+// affects each of them equally, then compare their times to the first one.
+//----------------------------------------------------------------------------
+{
+	struct Command {
+		string cmdline;
+		vector<sys::RunResult> runs;
+		vector<double> walls;
+	};
+	vector<Command> commands;
+	for (int i = 0; i < argc; ++i) {
+		auto words = CmdLine::split(argv[i]);
+		vector<const char*> ptrs;
+		for (const auto& w : words) ptrs.push_back(w.c_str());
+		if (ptrs.empty()) { cerr << "- Empty command to compare!\n"; return EXIT_USAGE; }
+		commands.push_back({CmdLine::build(ptrs.data(), (int)ptrs.size()), {}, {}});
+	}
+	if (commands.size() < 2) { cerr << "- Nothing to compare with!\n"; return EXIT_USAGE; }
+
+	auto t = [](double s) { return Timer::convert<CFG::Report_Time_Unit>(s); };
+	const auto unit = CFG::Report_Time_Unit::name;
+
+	normal_out << "Comparing " << commands.size() << " commands, " << cfg.Runs << " runs each";
+	if (cfg.Warmup) normal_out << " (+" << cfg.Warmup << " warmup)";
+	normal_out << ", interleaved:\n";
+	for (size_t c = 0; c < commands.size(); ++c)
+		normal_out << "  [" << c + 1 << "] " << commands[c].cmdline << '\n';
+
+	int exitcode = 0;
+	unsigned limited = 0;
+	for (unsigned round = 0; round < cfg.Warmup + cfg.Runs; ++round) {
+		// Also rotate the order, so that no command is always right after the same other one:
+		for (size_t k = 0; k < commands.size(); ++k) {
+			auto& cmd = commands[(round + k) % commands.size()];
+			sys::RunResult result; sys::syserr_t sys_error = 0;
+			if (!sys::run(cmd.cmdline, &result, &sys_error, run_options)) {
+				report_error(cmd.cmdline, sys_error);
+				return EXIT_RUN_FAILED;
+			}
+			if (round < cfg.Warmup) continue;
+			if (result.limit) ++limited;
+			else if (result.exitcode && !exitcode) exitcode = result.exitcode;
+			cmd.runs.push_back(result);
+			cmd.walls.push_back(measured(result));
+			exporter.record(cmd.cmdline, (unsigned)cmd.runs.size(), result);
+		}
+	}
+
+	vector<Stats> stats;
+	normal_out << '\n' << measured_name() << " (" << unit << "):\n";
+	for (size_t c = 0; c < commands.size(); ++c) {
+		const auto& s = stats.emplace_back(commands[c].walls);
+		normal_out << "  [" << c + 1 << "] mean: " << t(s.mean) << " +/- " << t(s.stddev)
+		           << ", median: " << t(s.median)
+		           << ", min/max: " << t(s.min) << " / " << t(s.max) << '\n';
+	}
+	if (run_options.counters) {
+		for (size_t c = 0; c < commands.size(); ++c) {
+			normal_out << "\n[" << c + 1 << "] ";
+			report_counters(commands[c].runs);
+		}
+	}
+
+	normal_out << "\nRelative to [1]:\n";
+	for (size_t c = 1; c < commands.size(); ++c) {
+		Welch w(stats[0], stats[c]);
+		auto speedup = stats[c].mean ? stats[0].mean / stats[c].mean : 0;
+		auto pct = [&](double d) { ostringstream o; o << showpos << fixed << setprecision(1)
+		                                              << d / stats[0].mean * 100 << '%'; return o.str(); };
+		normal_out << "  [" << c + 1 << "] ";
+		if (!w.valid) {
+			normal_out << speedup << "x (time diff.: " << pct(w.diff) << "; not enough runs for a CI)\n";
+			continue;
+		}
+		if (!w.significant())    normal_out << "no significant difference (" << speedup << "x";
+		else if (speedup >= 1)   normal_out << speedup << "x faster (";
+		else                     normal_out << 1 / speedup << "x slower (";
+		normal_out << (w.significant() ? "" : "; ")
+		           << "time diff.: " << pct(w.diff) << ", 95% CI: " << pct(w.lo) << " .. " << pct(w.hi) << ")\n";
+	}
+
+	if (exitcode)
+		cerr << "- Warning: some runs exited with non-zero code!\n";
+	if (limited) {
+		cerr << "- Warning: " << limited << " runs were killed at a limit (their results are partial)!\n";
+		return EXIT_LIMIT;
+	}
+	return exitcode;
+}
+
+//----------------------------------------------------------------------------
+// wtime's own options, with the number of parameters they take (-> Args)
+//----------------------------------------------------------------------------
+const Args::Rules OPTIONS = {
+	{"runs", 1},
+	{"warmup", 1},
+	{"compare", 0},
+	{"export-json", 1},
+	{"export-csv", 1},
+	{"export-ndjson", 1},
+	{"save-baseline", 1},
+	{"check-baseline", 1},
+	{"threshold", 1},
+	{"calibrate", 0}, // (Can still take a value with --calibrate=N)
+	{"subtract-overhead", 0},
+	{"counters", 0},
+	{"clock", 1},
+	{"output", 1},
+	{"until-output", 0},
+	{"until-match", 1},
+	{"kill-at-milestone", 0},
+	{"markers", 0},
+	{"clock-info", 0},
+	{"mem-sample", 1},
+	{"mem-timeline", 1},
+	{"thread-sample", 1},
+	{"tree", 0},
+	{"jobs", 1},
+	{"pin", 0},
+	{"batch", 1},
+	{"parallel", 1},
+	{"slowest", 1},
+	{"scan", 1},
+	{"cpus", 1},
+	{"high-priority", 0},
+	{"no-aslr", 0},
+	{"env-size", 1},
+	{"timeout", 1},
+	{"max-mem", 1},
+	{"max-cpu", 1},
+};
+
+//----------------------------------------------------------------------------
+int find_command(int argc, char const* const* argv, const Args::Rules& rules)
+// Returns the index of the first word of the command to run, i.e. where our
+// own options end. (Args alone would happily eat the child's options, too.)
+//----------------------------------------------------------------------------
+{
+	int i = 1;
+	while (i < argc) {
+		string_view arg = argv[i];
+		if (arg == "--") return i + 1;
+		if (arg.size() < 2 || arg[0] != '-') break;
+
+		bool has_value = false;
+		string name;
+		if (arg[1] == '-') { // --long[=value]
+			arg.remove_prefix(2);
+			auto eqpos = arg.find_first_of(":="); // (Same as Args!)
+			has_value = eqpos != string_view::npos;
+			name = arg.substr(0, eqpos);
+		} else { // -x or -xyz: only the last one could take params
+			name = arg.back();
+		}
+		auto rule = rules.find(name);
+		i += 1 + (has_value || rule == rules.end() ? 0 : std::max(0, rule->second));
+	}
+	return i;
+}
+
+//----------------------------------------------------------------------------
+bool get_percent(const Args& args, const string& opt, double& value) // "5%" or just "5"
+//----------------------------------------------------------------------------
+{
+	if (!args[opt]) return true;
+	try {
+		size_t end;
+		auto x = stod(args(opt), &end);
+		if ((end == args(opt).size() || args(opt).substr(end) == "%") && x >= 0) { value = x; return true; }
+	} catch (...) {}
+	cerr << "- Invalid value for --" << opt << ": \"" << args(opt) << "\"\n";
+	return false;
+}
+
+//----------------------------------------------------------------------------
+bool get_number(const Args& args, const string& opt, unsigned& value, unsigned min = 0)
+//----------------------------------------------------------------------------
+{
+	if (!args[opt]) return true;
+	try {
+		size_t end;
+		auto n = stoul(args(opt), &end);
+		if (end == args(opt).size() && n >= min) { value = (unsigned)n; return true; }
+	} catch (...) {}
+	cerr << "- Invalid value for --" << opt << ": \"" << args(opt) << "\"\n";
+	return false;
+}
+
+//----------------------------------------------------------------------------
+bool get_numbers(const Args& args, const string& opt, vector<unsigned>& values, unsigned min = 0) // "1,2,4" or "0,4-7"
+//----------------------------------------------------------------------------
+{
+	if (!args[opt]) return true;
+	values.clear();
+	string_view list = args(opt);
+	try {
+		while (!list.empty()) {
+			auto item = string(list.substr(0, list.find(',')));
+			list.remove_prefix(std::min(list.size(), item.size() + 1));
+			size_t end;
+			auto n = stoul(item, &end);
+			auto last = n;
+			if (end < item.size() && item[end] == '-') {
+				auto range_end = item.substr(end + 1);
+				last = stoul(range_end, &end);
+				if (end != range_end.size() || last < n) throw 0;
+			} else if (end != item.size()) throw 0;
+			if (n < min) throw 0;
+			for (; n <= last; ++n) values.push_back((unsigned)n);
+		}
+		if (!values.empty()) return true;
+	} catch (...) {}
+	cerr << "- Invalid value for --" << opt << ": \"" << args(opt) << "\"\n";
+	return false;
+}
+
+//----------------------------------------------------------------------------
+bool get_seconds(const Args& args, const string& opt, double& value) // "1.5", "1.5s", "500ms", "2m"
+//----------------------------------------------------------------------------
+{
+	if (!args[opt]) return true;
+	try {
+		size_t end;
+		auto x = stod(args(opt), &end);
+		auto unit = args(opt).substr(end);
+		double scale = unit.empty() || unit == "s" ? 1 : unit == "ms" ? 1e-3 : unit == "m" ? 60 : 0;
+		if (scale && x > 0) { value = x * scale; return true; }
+	} catch (...) {}
+	cerr << "- Invalid value for --" << opt << ": \"" << args(opt) << "\"\n";
+	return false;
+}
+
+//----------------------------------------------------------------------------
+bool get_kbytes(const Args& args, const string& opt, uint64_t& kb) // "512M", "2G", "100000K" (or KB)
+//----------------------------------------------------------------------------
+{
+	if (!args[opt]) return true;
+	try {
+		size_t end;
+		auto x = stod(args(opt), &end);
+		auto unit = args(opt).substr(end);
+		if (!unit.empty() && unit.back() == 'B') unit.pop_back();
+		double scale = unit.empty() || unit == "K" ? 1 : unit == "M" ? 1024 : unit == "G" ? 1024 * 1024 : 0;
+		if (scale && x * scale >= 1) { kb = uint64_t(x * scale); return true; }
+	} catch (...) {}
+	cerr << "- Invalid value for --" << opt << ": \"" << args(opt) << "\"\n";
+	return false;
+}
+
+int main(int argc, char* argv[], [[maybe_unused]] char* envp[])
+{
+	// The empty reference process for --calibrate (so, before anything else!):
+	if (argc == 2 && string_view(argv[1]) == "--noop") return 0;
+
+	// Set the console to UTF-8 (to be restored on exit)
+	//!! Doesn't seem to help, though, in certain (common?) scenarios! :-/
+	//!! Eg. I can `echo ŐŰ` just fine directly, but passing that to `cmd /c`
+	//!! would still strip the accents, no matter what!... :-o
+#ifdef _WIN32
+	sys::ConsoleCP set(CP_UTF8);
+#endif
+
+	// Response files: an @FILE in place of our options, or of the command, is
+	// replaced by the words in FILE (quoted the same way as here; newlines are
+	// just spaces), so even commands near the OS command line limits (like the
+	// link steps of big projects) can be run. (An @FILE among the args of the
+	// command is left alone, for the command itself.)
+	deque<string> response_words; // (Stable, for the new argv)
+	vector<char*> response_argv;
+	int cmd_at = find_command(argc, argv, OPTIONS);
+	for (unsigned files = 0; cmd_at < argc && argv[cmd_at][0] == '@' && argv[cmd_at][1]; ++files) {
+		const char* path = argv[cmd_at] + 1;
+		ifstream file(path);
+		if (!file) { cerr << "- Failed to open the response file \"" << path << "\"!\n"; return EXIT_USAGE; }
+		if (files == 16) { cerr << "- Too many nested response files (at \"" << path << "\")!\n"; return EXIT_USAGE; }
+		vector<char*> expanded(argv, argv + cmd_at);
+		string line;
+		while (getline(file, line)) {
+			if (!line.empty() && line.back() == '\r') line.pop_back();
+			for (auto& word : CmdLine::split(line))
+				expanded.push_back(response_words.emplace_back(std::move(word)).data());
+		}
+		expanded.insert(expanded.end(), argv + cmd_at + 1, argv + argc);
+		argc = (int)expanded.size();
+		expanded.push_back(nullptr);
+		response_argv = std::move(expanded);
+		argv = response_argv.data();
+		cmd_at = find_command(argc, argv, OPTIONS);
+	}
+
+	Args args(cmd_at, argv, OPTIONS);
+	if (args["v"] || args["verbose"]) cfg.Verbose = true;
+	if (args["compare"] && !args["runs"]) cfg.Runs = 10; // One sample is pointless for that
+	if (!get_number(args, "runs", cfg.Runs, 1) || !get_number(args, "warmup", cfg.Warmup)
+	    || !get_percent(args, "threshold", cfg.Threshold))
+		return EXIT_USAGE;
+	if (args["calibrate"] && !args("calibrate").empty() && !get_number(args, "calibrate", cfg.Calibration_Runs, 2))
+		return EXIT_USAGE;
+	cfg.Subtract_Overhead = args["subtract-overhead"];
+	if (args["clock"]) {
+		auto name = args("clock");
+		auto source = find(begin(Clock::Names), end(Clock::Names), name) - begin(Clock::Names);
+		if (name == "cpu") {
+			cfg.CPU_Clock = true;
+		} else if (source == Clock::SOURCES || !Clock::select(Clock::Source(source))) {
+			cerr << "- Unknown or unavailable clock: \"" << name << "\" (see --clock-info)\n";
+			return EXIT_USAGE;
+		}
+		if (Clock::selected() == Clock::TSC && !Clock::tsc_invariant())
+			cerr << "- Warning: the TSC is not invariant here, so its rate may change with the CPU frequency!\n";
+		if (cfg.CPU_Clock && (cfg.Subtract_Overhead || args["calibrate"])) {
+			cerr << "- The launch overhead can't be calibrated for --clock cpu!\n";
+			return EXIT_USAGE;
+		}
+	}
+	if (args["output"]) {
+		string mode = args("output");
+		if      (mode == "discard") run_options.output = sys::RunOptions::DISCARD;
+		else if (mode == "count")   run_options.output = sys::RunOptions::COUNT;
+		else if (mode.starts_with("file:") && mode.size() > 5) {
+			run_options.output = sys::RunOptions::TO_FILE;
+			run_options.output_file = mode.substr(5);
+			if (!ofstream(run_options.output_file)) { cerr << "- Failed to open \"" << run_options.output_file << "\" for --output!\n"; return EXIT_USAGE; }
+		} else {
+			cerr << "- Invalid value for --output: \"" << mode << "\" (expected discard, count or file:PATH)\n";
+			return EXIT_USAGE;
+		}
+	}
+	run_options.until_output = args["until-output"];
+	if (args["until-match"]) {
+		try { run_options.until_match.emplace(args("until-match")); }
+		catch (const regex_error& e) {
+			cerr << "- Invalid regex for --until-match: \"" << args("until-match") << "\" (" << e.what() << ")\n";
+			return EXIT_USAGE;
+		}
+	}
+	if (run_options.until_output || run_options.until_match) {
+		if (run_options.output == sys::RunOptions::TO_FILE) { cerr << "- --until-* can't be used with --output file!\n"; return EXIT_USAGE; }
+		if (cfg.CPU_Clock) { cerr << "- --until-* can't be used with --clock cpu!\n"; return EXIT_USAGE; }
+	}
+	run_options.markers = args["markers"];
+	run_options.kill_at_milestone = args["kill-at-milestone"];
+	if (run_options.kill_at_milestone && !run_options.until_output && !run_options.until_match) {
+		cerr << "- --kill-at-milestone needs --until-output or --until-match!\n";
+		return EXIT_USAGE;
+	}
+	if (cfg.Subtract_Overhead && (run_options.until_output || run_options.until_match)) {
+		// (The time of a milestone doesn't include the wait for the exit, that's also calibrated.)
+		cerr << "- --subtract-overhead can't be used with --until-output or --until-match!\n";
+		return EXIT_USAGE;
+	}
+	if (args["clock-info"]) {
+		clock_info();
+		if (cmd_at >= argc) return 0; // Nothing else to do
+	}
+	run_options.counters = args["counters"];
+#ifndef __linux__
+	if (run_options.counters) cerr << "- Warning: performance counters are only supported on Linux.\n";
+#endif
+	if (args["mem-sample"]) {
+		unsigned hz = 0;
+		if (!get_number(args, "mem-sample", hz, 1)) return EXIT_USAGE;
+		mem_sampler = make_unique<sys::MemSampler>(hz);
+		run_options.monitors.push_back(mem_sampler.get());
+	}
+	if (args["mem-timeline"]) {
+		if (!mem_sampler) { cerr << "- --mem-timeline needs --mem-sample!\n"; return EXIT_USAGE; }
+		mem_timeline.open(args("mem-timeline"));
+		if (!mem_timeline) { cerr << "- Failed to open \"" << args("mem-timeline") << "\" for --mem-timeline!\n"; return EXIT_USAGE; }
+		mem_timeline << "run\tt_s\trss_kb\tpss_kb\tswap_kb\n";
+	}
+	if (args["thread-sample"]) {
+		unsigned hz = 0;
+		if (!get_number(args, "thread-sample", hz, 1)) return EXIT_USAGE;
+#if !defined(_WIN32) && !defined(__linux__)
+		cerr << "- Warning: --thread-sample is only supported on Linux and Windows.\n";
+#endif
+		thread_sampler = make_unique<sys::ThreadSampler>(hz);
+		run_options.monitors.push_back(thread_sampler.get());
+	}
+	run_options.tree = args["tree"];
+#if !defined(_WIN32) && !defined(__linux__)
+	if (run_options.tree) cerr << "- Warning: --tree can only wait for the direct child here.\n";
+#endif
+	if (!get_numbers(args, "cpus", run_options.cpus)) return EXIT_USAGE;
+	run_options.high_priority = args["high-priority"];
+	run_options.no_aslr = args["no-aslr"];
+	if (args["env-size"]) {
+		unsigned env_size = 0;
+		if (!get_number(args, "env-size", env_size, 1)) return EXIT_USAGE;
+		run_options.env_size = env_size;
+	}
+	if (!get_seconds(args, "timeout", run_options.timeout)
+	 || !get_kbytes(args, "max-mem", run_options.max_mem)
+	 || !get_seconds(args, "max-cpu", run_options.max_cpu)) return EXIT_USAGE;
+#if !defined(_WIN32) && !defined(__linux__)
+	if (run_options.max_mem || run_options.max_cpu > 0)
+		cerr << "- Warning: --max-mem and --max-cpu are only supported on Linux and Windows.\n";
+#endif
+	cfg.Save_Baseline = args("save-baseline");
+	cfg.Check_Baseline = args("check-baseline");
+	if ((!cfg.Save_Baseline.empty() || !cfg.Check_Baseline.empty()) && cfg.Runs < 2) {
+		cerr << "- --save-baseline and --check-baseline need at least --runs 2 (for a confidence interval)!\n";
+		return EXIT_USAGE;
+	}
+	if (!cfg.Check_Baseline.empty()) { // (Fail early, and not as "no regression"!)
+		Baseline baseline;
+		if (!baseline.load(cfg.Check_Baseline)) {
+			cerr << "- Failed to load the baseline \"" << cfg.Check_Baseline << "\" from \"" << Baseline::path(cfg.Check_Baseline) << "\"!\n";
+			return EXIT_USAGE;
+		}
+		if (baseline.samples.size() < 2) {
+			cerr << "- The baseline \"" << cfg.Check_Baseline << "\" has only " << baseline.samples.size()
+			     << " sample(s), but at least 2 are needed (save it with --runs 2 or more)!\n";
+			return EXIT_USAGE;
+		}
+	}
+
+	vector<unsigned> jobs;
+	if (!get_numbers(args, "jobs", jobs, 1)) return EXIT_USAGE;
+	if (!jobs.empty()) {
+		// (The process tree and the memory sampler can't tell the instances apart.)
+		for (auto opt : {"compare", "tree", "mem-sample", "thread-sample", "save-baseline", "check-baseline"})
+			if (args[opt]) { cerr << "- --jobs can't be used with --" << opt << "!\n"; return EXIT_USAGE; }
+		// (Nor could the instances all truncate & write the same file.)
+		if (run_options.output == sys::RunOptions::TO_FILE) { cerr << "- --jobs can't be used with --output file!\n"; return EXIT_USAGE; }
+	}
+	if (args["pin"] && jobs.empty()) { cerr << "- --pin needs --jobs!\n"; return EXIT_USAGE; }
+	if (args["scan"]) {
+		for (auto opt : {"compare", "jobs", "save-baseline", "check-baseline"})
+			if (args[opt]) { cerr << "- --scan can't be used with --" << opt << "!\n"; return EXIT_USAGE; }
+	}
+
+	unsigned parallel = std::max(1u, thread::hardware_concurrency()), slowest = 10;
+	if (!get_number(args, "parallel", parallel, 1) || !get_number(args, "slowest", slowest, 1)) return EXIT_USAGE;
+	if (args["batch"]) {
+		for (auto opt : {"compare", "jobs", "scan", "tree", "mem-sample", "thread-sample", "save-baseline", "check-baseline"})
+			if (args[opt]) { cerr << "- --batch can't be used with --" << opt << "!\n"; return EXIT_USAGE; }
+		if (run_options.output == sys::RunOptions::TO_FILE) { cerr << "- --batch can't be used with --output file!\n"; return EXIT_USAGE; }
+		if (cmd_at < argc) { cerr << "- --batch takes the commands from the file, not the command line!\n"; return EXIT_USAGE; }
+	}
+
+	for (auto [opt, open] : {pair{"export-json", &Exporter::open_json},
+	                         pair{"export-csv", &Exporter::open_csv},
+	                         pair{"export-ndjson", &Exporter::open_ndjson}})
+		if (args[opt] && !(exporter.*open)(args(opt))) {
+			cerr << "- Failed to open \"" << args(opt) << "\" for --" << opt << "!\n";
+			return EXIT_USAGE;
+		}
+
+	if (args["calibrate"] || cfg.Subtract_Overhead) {
+		launch_overhead = calibrate(sys::self_path(argv[0]), cfg.Calibration_Runs);
+		if (!launch_overhead.n) return EXIT_RUN_FAILED;
+		if (args["calibrate"] || cfg.Verbose) {
+			auto t = [](double s) { return Timer::convert<CFG::Report_Time_Unit>(s); };
+			normal_out
+				<< "Launch overhead (" << CFG::Report_Time_Unit::name << ", " << launch_overhead.n << " runs of an empty process):\n"
+				<< "  mean:    " << t(launch_overhead.mean) << " +/- " << t(launch_overhead.stddev) << " (stddev)\n"
+				<< "  median:  " << t(launch_overhead.median) << '\n'
+				<< "  min/max: " << t(launch_overhead.min) << " / " << t(launch_overhead.max) << '\n';
+		}
+		if (args["calibrate"] && cmd_at >= argc) return 0; // Nothing else to do
+	}
+
+	if (args["batch"] && !args["h"] && !args["help"])
+		return batch(args("batch"), parallel, slowest);
+
+	if (cmd_at >= argc || args["h"] || args["help"]) {
+		cerr
+			<< TOOLNAME << " version " << VERSION
+			<< " (" << sys::BitArchTag() << "-bit)"
+			<< " -> https://github.com/x1ab/wtime"
+			<< '\n'
+			<< "Usage: " << TOOLNAME << " [options] exename [args...]\n"
+			<< R"(
+Options:
+
+  --runs N       Run the command N times, and report statistics of the results
+                 (mean, median, stddev, percentiles, outliers, histogram).
+  --warmup K     Run the command K more times first, without measuring it.
+  --compare      Each arg is a complete command (quoted as one) to be timed
+                 against the first one, in interleaved runs (10 by default).
+  --export-json FILE, --export-csv FILE
+                 Write every measured run (command, exit code, times, resource
+                 use, host info, timestamp) to FILE, as a JSON array or CSV.
+  --export-ndjson FILE
+                 Same, but as one JSON object per line, appended to FILE
+                 and flushed after each run (so it can be followed live).
+  --save-baseline NAME
+                 Save the measured times as NAME.baseline (in the current dir.,
+                 or in $WTIME_BASELINE_DIR, if set).
+  --check-baseline NAME
+                 Compare the measured times to the saved baseline NAME, and
+                 fail (see below) if they are significantly slower, and also
+                 by more than the threshold. (Both need --runs 2 or more, and
+                 a missing or too small baseline is an error, too.)
+  --threshold P  Slowdown (%) tolerated by --check-baseline (default: 5%).
+  --calibrate[=N]
+                 Estimate our own overhead of launching and waiting for a
+                 process, by timing an empty one N times (default: 100).
+  --subtract-overhead
+                 Calibrate (see above), and subtract that overhead from the
+                 results (also accounting for its uncertainty; but not below 0,
+                 and not with the milestones of --until-*).
+  --counters     Also collect hardware performance counters (cycles, instr.,
+                 IPC, cache refs/misses, branch misses, task clock) of the
+                 command and all its threads/subprocesses. (Linux only.)
+  --mem-sample HZ
+                 Sample the memory use of the command HZ times per second,
+                 to report its peak (and when it happened) and average.
+  --mem-timeline FILE
+                 Save all the memory samples to FILE (as TSV, for plotting).
+  --thread-sample HZ
+                 Sample the CPU time of each thread of the command HZ times
+                 per second, to report the average and peak parallelism (CPU
+                 time / elapsed time), the number of threads, and the busiest
+                 ones. (Of its own process only; Linux and Windows only.)
+  --tree         Wait for all the subprocesses of the command, too (even if
+                 left running in the background), and account their resource
+                 use; also show a breakdown by process. (Useful for shell
+                 scripts and batch files; Linux and Windows only. The max RSS
+                 is then of the largest process on Linux, and the peak of the
+                 committed memory of all of them on Windows.)
+  --jobs N,M,... Run N (then M etc.) instances of the command at once, and
+                 report the makespan, the latency of the instances, and the
+                 throughput and scaling efficiency relative to one instance.
+  --pin          Pin the instances of --jobs to one CPU each (round-robin,
+                 over the --cpus, if given). (Linux and Windows only.)
+  --batch FILE   Time each command listed in FILE (one per line, quoted the
+                 same way as here; blank lines and #comments are ignored),
+                 and report the slowest ones.
+  --parallel N   Run the --batch commands on N workers (default: all CPUs).
+  --slowest N    Number of commands in the --batch report (default: 10).
+  --scan NAME=START:END:STEP
+                 Run the command with each value of NAME (from START to END,
+                 adding STEP, or multiplying by it as xSTEP) put in place of
+                 {NAME} in its args (at most 1000 values), and fit the
+                 (median) times to O(1), O(log n), O(n), O(n log n) and
+                 O(n^2), e.g.: --scan N=1000:1000000:x10 mytool --size {N}
+                 (It stays O(1), unless the growth is significant.)
+  --clock NAME   Time source for the elapsed time: steady (the default), raw
+                 (CLOCK_MONOTONIC_RAW), boottime (CLOCK_BOOTTIME; both Linux
+                 only), tsc (calibrated CPU timestamp counter; x86 only), or
+                 measure the CPU time of the command's own process with cpu.
+  --clock-info   Show the resolution and the cost of reading each clock.
+  --output MODE  Where the command's stdout & stderr go, instead of the console
+                 (whose rendering would be timed, too): discard (to the null
+                 device), count (into a pipe, to report the bytes written and
+                 the throughput), or file:PATH (also reporting its size; not
+                 with --jobs or --batch).
+  --until-output Measure the time until the first byte of output, instead.
+  --until-match REGEX
+                 Measure the time until the output first matches REGEX (e.g.
+                 a "ready" message; ECMAScript syntax), instead.
+                 (Both watch stdout & stderr through a pipe, so the command
+                 must flush its output, as it's not going to a terminal.)
+  --kill-at-milestone
+                 Kill the command (with its subprocesses) when the above is
+                 reached (e.g. a server).
+  --markers      Let the command mark the start of its phases, by writing
+                 lines (like "phase:load") to $WTIME_MARK_FD (a pipe; e.g.
+                 `echo phase:load >&$WTIME_MARK_FD`, or on Windows, a named
+                 pipe: `echo phase:load > %WTIME_MARK_FD%`), and report the
+                 time spent in each phase.
+  --cpus LIST    Pin the command to these CPUs (e.g. 2,3 or 4-7), to keep it
+                 off busy (or slower) cores. (Linux and Windows only.)
+  --high-priority
+                 Run the command at a raised priority (Windows: HIGH priority
+                 class; elsewhere: nice -10, which needs root/CAP_SYS_NICE).
+  --no-aslr      Disable address space randomization for the command, to get
+                 the same memory layout in every run. (Linux and macOS only.)
+  --env-size BYTES
+                 Pad the command's environment (with a WTIME_ENV_PAD variable)
+                 to this size, as it shifts the initial stack, and with it
+                 the alignment of everything on it, which can alone change
+                 the times by several percent (not only across machines).
+                 (The controls actually applied are reported, and exported.)
+  --timeout T    Kill the command (with all its subprocesses) if it's still
+                 running after T seconds (or e.g. 500ms, 2m).
+  --max-mem SIZE Kill it if it uses more than SIZE memory (e.g. 512M, 2G; RSS
+                 of the command itself on Linux, or of all its processes with
+                 --tree, the committed memory of all of them on Windows).
+  --max-cpu T    Kill it if it uses more than T seconds of CPU time (user +
+                 system; of the command itself on Linux, or of all its
+                 processes with --tree, and of all of them on Windows).
+                 (A run killed at a limit is reported as such, with whatever
+                 results were collected, and then no more runs are done. The
+                 command is run in its own process group then, on POSIX (also
+                 with --kill-at-milestone), which is given the terminal for
+                 the run (if wtime had it), and gets Ctrl-C & co. passed on.)
+  @FILE          Read (more of) our options, and/or the command, from FILE.
+                 (Quoted the same way as here, but newlines are just spaces.)
+  -v, --verbose  Show what's being done (e.g. the time of each run).
+  --             End of options (if the command itself starts with a `-`).
+
+Notes:
+
+  - `exename` must be a standalone executable. (Shell built-ins can be run
+    with explicit shell commands like: `wtime cmd /c echo OK`.)
+
+    Batch files can be run directly (well, obviously still invoking CMD for
+    them). The .cmd or .bat extension can be omitted, just like the .exe
+    (or .com) of real binaries.
+
+  - Quotes around parameters with spaces will be preserved. (Unlike the default
+    behavior on Windows; so no need for e.g. the mildly perverted triple-quote
+    syntax with CMD, like `wtime busybox cat """one two.txt"""`).
+
+    There's also support for quoting (and honoring) escaped special chars using
+    Win32's \ syntax (not the ^ syntax of CMD, sorry!), but for anything more
+    complex, or if you find yourself stuck fighting this, honestly, call 911.
+
+  - Wildcards are not expanded.
+
+  - The exit code is the command's own (of its last run), except:
+    -1: bad options, or a missing baseline (or this help),
+    -2: failed to run the command,
+    -3: performance regression (--check-baseline; even if the command
+        itself failed, too),
+    -4: killed at a limit (--timeout, --max-mem, --max-cpu).
+
+)";
+
+		cerr	<< "(BTW, just for the fun of it: printing this took "
+			<< chrono::duration<double, milli>(chrono::steady_clock::now() - bailout_start).count()
+			<< " milliseconds.)\n";
+
+		return EXIT_USAGE;
+	}
+
+	argv += cmd_at; argc -= cmd_at; // Skip our own options
+
+	if (args["compare"])
+		return compare(argc, argv);
+
+	const string child_exe = argv[0]; assert(!child_exe.empty());
+	string child_exe_escaped = CmdLine::quote(child_exe); assert(!child_exe_escaped.empty());
+		// Need to manually escape the exe name. (Arg lists from CmdLine::build are escaped implicitly!)
+	++argv; --argc; //!! shift
+	string child_args = CmdLine::build(argv, argc); //!! Add this feature to Args!
+	string cmdline = child_exe_escaped + (child_args.empty() ? "" : " ") + child_args;
+
+	// Find the executable (-> #2) before any timed runs; sys::run will then
+	// just use it from the cache, without searching the PATH each time:
+	Timer resolve_timer(Timer::Start);
+	string child_path;
+	bool found = sys::find_executable(child_exe, &child_path);
+	resolve_timer.stop();
+	if (cfg.Verbose) normal_out << "Resolved: " << child_exe << " -> " << (found ? child_path : "(not found)")
+	                            << " (in " << resolve_timer.elapsed<TimeUnit::ms>() << " ms)\n";
+	if (!found) {
+		report_error(child_exe, sys::ERR_NOT_FOUND);
+		return EXIT_RUN_FAILED;
+	}
+
+	if (cfg.Verbose) normal_out << "Executing: " << cmdline <<"...\n";
+
+	if (!jobs.empty())
+		return scale(child_exe, cmdline, jobs, args["pin"]);
+
+	if (args["scan"])
+		return scan(child_exe, argv - 1, argc + 1, args("scan")); // (With the exe again)
 
-	return -2;
+	return benchmark(child_exe, cmdline);
 }